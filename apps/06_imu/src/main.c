@@ -25,6 +25,11 @@ int main(void)
 		struct sensor_value accel[3], gyro[3];
 
 		int rc = sensor_sample_fetch(imu);
+		if (rc == -EBUSY) {
+			/* no new sample within the fetch timeout, try again */
+			LOG_WRN("No new sample");
+			continue;
+		}
 		if (rc) {
 			LOG_ERR("Error %d: failed to fetch sample", rc);
 			return -EIO;
@@ -9,30 +9,29 @@
 
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/drivers/spi.h>
+#include <zephyr/pm/device.h>
+#include <zephyr/sys/barrier.h>
 #include <zephyr/sys/byteorder.h>
 #include "icm42670.h"
+#include "icm42670_apex.h"
+#include "icm42670_calib.h"
+#include "icm42670_cache.h"
+#include "icm42670_convert.h"
+#include "icm42670_decoder.h"
+#include "icm42670_fifo.h"
+#include "icm42670_policy.h"
 #include "icm42670_reg.h"
+#include "icm42670_rtio.h"
 #include "icm42670_trigger.h"
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(ICM42670, CONFIG_SENSOR_LOG_LEVEL);
 
-/*
- * Gyro FS to scaling factor mapping.
- * See datasheet section 3.1 for details
- */
-static const uint16_t icm42670_gyro_sensitivity_x10[] = {
-	164, /* BIT_GYRO_UI_FS_2000 */
-	328, /* BIT_GYRO_UI_FS_1000 */
-	655, /* BIT_GYRO_UI_FS_500 */
-	1310, /* BIT_GYRO_UI_FS_250 */
-};
-
 static int icm42670_set_accel_fs(const struct device *dev, uint16_t fs)
 {
-	const struct icm42670_config *cfg = dev->config;
 	struct icm42670_data *data = dev->data;
 	uint8_t temp;
+	int res;
 
 	if ((fs > 16) || (fs < 2)) {
 		LOG_ERR("Unsupported range");
@@ -49,17 +48,22 @@ static int icm42670_set_accel_fs(const struct device *dev, uint16_t fs)
 		temp = BIT_ACCEL_UI_FS_2;
 	}
 
-	data->accel_sensitivity_shift = MIN_ACCEL_SENS_SHIFT + temp;
+	res = icm42670_reg_update(dev, REG_ACCEL_CONFIG0, (uint8_t)MASK_ACCEL_UI_FS_SEL, temp);
+
+	if (res) {
+		return res;
+	}
+
+	data->accel_fs_sel = temp;
 
-	return cfg->bus_io->update(&cfg->bus, REG_ACCEL_CONFIG0,
-					    (uint8_t)MASK_ACCEL_UI_FS_SEL, temp);
+	return 0;
 }
 
 static int icm42670_set_gyro_fs(const struct device *dev, uint16_t fs)
 {
-	const struct icm42670_config *cfg = dev->config;
 	struct icm42670_data *data = dev->data;
 	uint8_t temp;
+	int res;
 
 	if ((fs > 2000) || (fs < 250)) {
 		LOG_ERR("Unsupported range");
@@ -76,15 +80,19 @@ static int icm42670_set_gyro_fs(const struct device *dev, uint16_t fs)
 		temp = BIT_GYRO_UI_FS_250;
 	}
 
-	data->gyro_sensitivity_x10 = icm42670_gyro_sensitivity_x10[temp];
+	res = icm42670_reg_update(dev, REG_GYRO_CONFIG0, (uint8_t)MASK_GYRO_UI_FS_SEL, temp);
+
+	if (res) {
+		return res;
+	}
+
+	data->gyro_fs_sel = temp;
 
-	return cfg->bus_io->update(&cfg->bus, REG_GYRO_CONFIG0,
-					    (uint8_t)MASK_GYRO_UI_FS_SEL, temp);
+	return 0;
 }
 
 static int icm42670_set_accel_odr(const struct device *dev, uint16_t rate)
 {
-	const struct icm42670_config *cfg = dev->config;
 	uint8_t temp;
 
 	if ((rate > 1600) || (rate < 1)) {
@@ -116,13 +124,11 @@ static int icm42670_set_accel_odr(const struct device *dev, uint16_t rate)
 		temp = BIT_ACCEL_ODR_1;
 	}
 
-	return cfg->bus_io->update(&cfg->bus, REG_ACCEL_CONFIG0, (uint8_t)MASK_ACCEL_ODR,
-					    temp);
+	return icm42670_reg_update(dev, REG_ACCEL_CONFIG0, (uint8_t)MASK_ACCEL_ODR, temp);
 }
 
 static int icm42670_set_gyro_odr(const struct device *dev, uint16_t rate)
 {
-	const struct icm42670_config *cfg = dev->config;
 	uint8_t temp;
 
 	if ((rate > 1600) || (rate < 12)) {
@@ -148,8 +154,119 @@ static int icm42670_set_gyro_odr(const struct device *dev, uint16_t rate)
 		temp = BIT_GYRO_ODR_12;
 	}
 
-	return cfg->bus_io->update(&cfg->bus, REG_GYRO_CONFIG0, (uint8_t)MASK_GYRO_ODR,
-					    temp);
+	return icm42670_reg_update(dev, REG_GYRO_CONFIG0, (uint8_t)MASK_GYRO_ODR, temp);
+}
+
+static int icm42670_set_accel_avg(const struct device *dev, uint16_t samples)
+{
+	struct icm42670_data *data = dev->data;
+	uint8_t temp;
+	int res;
+
+	if ((samples > 64) || (samples < 2)) {
+		LOG_ERR("Unsupported averaging");
+		return -ENOTSUP;
+	}
+
+	if (samples > 32) {
+		temp = BIT_ACCEL_UI_AVG_64;
+	} else if (samples > 16) {
+		temp = BIT_ACCEL_UI_AVG_32;
+	} else if (samples > 8) {
+		temp = BIT_ACCEL_UI_AVG_16;
+	} else if (samples > 4) {
+		temp = BIT_ACCEL_UI_AVG_8;
+	} else if (samples > 2) {
+		temp = BIT_ACCEL_UI_AVG_4;
+	} else {
+		temp = BIT_ACCEL_UI_AVG_2;
+	}
+
+	res = icm42670_reg_update(dev, REG_ACCEL_CONFIG1, (uint8_t)MASK_ACCEL_UI_AVG, temp);
+
+	if (res) {
+		return res;
+	}
+
+	data->accel_avg = BIT(temp + 1);
+
+	return 0;
+}
+
+/* true if wake on motion or an APEX detector is watching the accel */
+static bool icm42670_on_chip_detection(const struct icm42670_data *data)
+{
+#ifdef CONFIG_ICM42670_APEX
+	if (data->apex_active) {
+		return true;
+	}
+#endif
+#ifdef CONFIG_ICM42670_TRIGGER
+	if (data->motion_handler) {
+		return true;
+	}
+#endif
+	ARG_UNUSED(data);
+
+	return false;
+}
+
+/* the power mode the requested mode, sampling rate and averaging call for */
+static uint8_t icm42670_accel_power_select(const struct icm42670_data *data)
+{
+	if (data->accel_power_mode != ICM42670_ACCEL_POWER_AUTO) {
+		return data->accel_power_mode;
+	}
+
+	/* the host sleeps while the chip watches for events, those do not need low noise */
+	if (icm42670_on_chip_detection(data) && (data->accel_hz <= MAX_ACCEL_LP_ODR)) {
+		return ICM42670_ACCEL_POWER_LP;
+	}
+
+	/* without a noise budget there is no telling whether the LP noise is acceptable */
+	if (data->accel_avg == 0) {
+		return ICM42670_ACCEL_POWER_LN;
+	}
+
+	/* each output averages a burst of samples, longer bursts lower the reachable rate */
+	uint16_t max_odr = MIN(MAX_ACCEL_LP_ODR, (MAX_ACCEL_LP_ODR * 4) / data->accel_avg);
+
+	return (data->accel_hz <= max_odr) ? ICM42670_ACCEL_POWER_LP : ICM42670_ACCEL_POWER_LN;
+}
+
+int icm42670_update_accel_power(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	uint8_t mode = icm42670_accel_power_select(data);
+	int res;
+
+	if (mode == ICM42670_ACCEL_POWER_LP) {
+		if (data->accel_hz > MAX_ACCEL_LP_ODR) {
+			LOG_ERR("Sampling frequency too high for low power mode");
+			return -ENOTSUP;
+		}
+
+		/* duty-cycle from the RC oscillator, the wake-up oscillator caps the rate */
+		res = icm42670_reg_update(dev, REG_PWR_MGMT0, (uint8_t)BIT_ACCEL_LP_CLK_SEL, 1);
+
+		if (res) {
+			return res;
+		}
+
+		res = icm42670_reg_update(dev, REG_PWR_MGMT0, (uint8_t)MASK_ACCEL_MODE,
+					  BIT_ACCEL_MODE_LPM);
+	} else {
+		res = icm42670_reg_update(dev, REG_PWR_MGMT0, (uint8_t)MASK_ACCEL_MODE,
+					  BIT_ACCEL_MODE_LNM);
+	}
+
+	if (res) {
+		return res;
+	}
+
+	data->accel_power_active = mode;
+
+	return 0;
 }
 
 static int icm42670_enable_mclk(const struct device *dev)
@@ -157,7 +274,7 @@ static int icm42670_enable_mclk(const struct device *dev)
 	const struct icm42670_config *cfg = dev->config;
 
 	/* switch on MCLK by setting the IDLE bit */
-	int res = cfg->bus_io->write(&cfg->bus, REG_PWR_MGMT0, BIT_IDLE);
+	int res = icm42670_reg_write(dev, REG_PWR_MGMT0, BIT_IDLE);
 
 	if (res) {
 		return res;
@@ -168,7 +285,7 @@ static int icm42670_enable_mclk(const struct device *dev)
 		uint8_t value = 0;
 
 		k_usleep(MCLK_POLL_INTERVAL_US);
-		res = cfg->bus_io->read(&cfg->bus, REG_MCLK_RDY, &value, 1);
+		res = icm42670_bus_read(cfg, REG_MCLK_RDY, &value, 1);
 
 		if (res) {
 			return res;
@@ -182,43 +299,48 @@ static int icm42670_enable_mclk(const struct device *dev)
 	return -EIO;
 }
 
-static int icm42670_sensor_init(const struct device *dev)
+static int icm42670_sensor_reset(const struct device *dev)
 {
-	int res;
-	uint8_t value;
 	const struct icm42670_config *cfg = dev->config;
 
-	/* start up time for register read/write after POR is 1ms and supply ramp time is 3ms */
-	k_msleep(3);
-
 	/* perform a soft reset to ensure a clean slate, reset bit will auto-clear */
-	res = cfg->bus_io->write(&cfg->bus, REG_SIGNAL_PATH_RESET, BIT_SOFT_RESET);
+	int res = icm42670_bus_write(cfg, REG_SIGNAL_PATH_RESET, BIT_SOFT_RESET);
 
 	if (res) {
 		LOG_ERR("write REG_SIGNAL_PATH_RESET failed");
 		return res;
 	}
 
-	/* wait for soft reset to take effect */
-	k_msleep(SOFT_RESET_TIME_MS);
+	/* all registers are back at their reset values */
+	icm42670_reg_cache_invalidate(dev);
+
+	return 0;
+}
+
+/* second half of the sensor init, to be run SOFT_RESET_TIME_MS after the reset */
+static int icm42670_sensor_configure(const struct device *dev)
+{
+	int res;
+	uint8_t value;
+	const struct icm42670_config *cfg = dev->config;
 
 	/* force SPI-4w hardware configuration (so that next read is correct) */
-	res = cfg->bus_io->write(&cfg->bus, REG_DEVICE_CONFIG, BIT_SPI_AP_4WIRE);
+	res = icm42670_reg_write(dev, REG_DEVICE_CONFIG, BIT_SPI_AP_4WIRE);
 
 	if (res) {
 		return res;
 	}
 
 	/* always use internal RC oscillator */
-	res = cfg->bus_io->write(&cfg->bus, REG_INTF_CONFIG1,
-					(uint8_t)FIELD_PREP(MASK_CLKSEL, BIT_CLKSEL_INT_RC));
+	res = icm42670_reg_write(dev, REG_INTF_CONFIG1,
+				 (uint8_t)FIELD_PREP(MASK_CLKSEL, BIT_CLKSEL_INT_RC));
 
 	if (res) {
 		return res;
 	}
 
 	/* clear reset done int flag */
-	res = cfg->bus_io->read(&cfg->bus, REG_INT_STATUS, &value, 1);
+	res = icm42670_bus_read(cfg, REG_INT_STATUS, &value, 1);
 
 	if (res) {
 		return res;
@@ -236,7 +358,7 @@ static int icm42670_sensor_init(const struct device *dev)
 		return res;
 	}
 
-	res = cfg->bus_io->read(&cfg->bus, REG_WHO_AM_I, &value, 1);
+	res = icm42670_bus_read(cfg, REG_WHO_AM_I, &value, 1);
 
 	if (res) {
 		return res;
@@ -249,26 +371,106 @@ static int icm42670_sensor_init(const struct device *dev)
 
 	LOG_DBG("device id: 0x%02X", value);
 
-	return 0;
+	/* prime the cache with the sensor configuration block */
+	res = icm42670_reg_cache_sync(dev);
+
+#ifdef CONFIG_ICM42670_CALIBRATION
+	if (!res) {
+		res = icm42670_calib_restore(dev);
+	}
+#endif
+
+	return res;
 }
 
-static int icm42670_turn_on_sensor(const struct device *dev)
+static int icm42670_sensor_init(const struct device *dev)
+{
+	/* start up time for register read/write after POR is 1ms and supply ramp time is 3ms */
+	k_msleep(POWER_UP_TIME_MS);
+
+	int res = icm42670_sensor_reset(dev);
+
+	if (res) {
+		return res;
+	}
+
+	/* wait for soft reset to take effect */
+	k_msleep(SOFT_RESET_TIME_MS);
+
+	return icm42670_sensor_configure(dev);
+}
+
+/* note the time at which an output switched on now starts producing valid data */
+static void icm42670_mark_startup(int64_t *valid_at, uint32_t ms)
+{
+	*valid_at = k_uptime_ticks() + k_ms_to_ticks_ceil64(ms);
+}
+
+void icm42670_wait_startup(const struct device *dev, enum sensor_channel chan)
 {
 	struct icm42670_data *data = dev->data;
+	int64_t valid_at;
+
+	switch (chan) {
+	case SENSOR_CHAN_ACCEL_XYZ:
+	case SENSOR_CHAN_ACCEL_X:
+	case SENSOR_CHAN_ACCEL_Y:
+	case SENSOR_CHAN_ACCEL_Z:
+		valid_at = data->accel_valid_at;
+		break;
+	case SENSOR_CHAN_GYRO_XYZ:
+	case SENSOR_CHAN_GYRO_X:
+	case SENSOR_CHAN_GYRO_Y:
+	case SENSOR_CHAN_GYRO_Z:
+		valid_at = data->gyro_valid_at;
+		break;
+	default:
+		valid_at = MAX(data->accel_valid_at, data->gyro_valid_at);
+		break;
+	}
+
+	int64_t remaining = valid_at - k_uptime_ticks();
+
+	if (remaining > 0) {
+		k_sleep(K_TICKS(remaining));
+	}
+}
+
+#ifdef CONFIG_ICM42670_FIXED_CONFIG
+
+/* the devicetree settings were turned into register values at build time */
+static int icm42670_set_fixed_config(const struct device *dev)
+{
 	const struct icm42670_config *cfg = dev->config;
-	uint8_t value;
+	struct icm42670_data *data = dev->data;
 	int res;
 
-	value = FIELD_PREP(MASK_ACCEL_MODE, BIT_ACCEL_MODE_LNM) |
-		FIELD_PREP(MASK_GYRO_MODE, BIT_GYRO_MODE_LNM);
+	res = icm42670_reg_write(dev, REG_ACCEL_CONFIG0, cfg->accel_config0);
+
+	if (res) {
+		return res;
+	}
+
+	data->accel_fs_sel = FIELD_GET(MASK_ACCEL_UI_FS_SEL, cfg->accel_config0);
 
-	res = cfg->bus_io->update(&cfg->bus, REG_PWR_MGMT0,
-					   (uint8_t)(MASK_ACCEL_MODE | MASK_GYRO_MODE), value);
+	res = icm42670_reg_write(dev, REG_GYRO_CONFIG0, cfg->gyro_config0);
 
 	if (res) {
 		return res;
 	}
 
+	data->gyro_fs_sel = FIELD_GET(MASK_GYRO_UI_FS_SEL, cfg->gyro_config0);
+
+	return 0;
+}
+
+#else
+
+static int icm42670_set_runtime_config(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
 	res = icm42670_set_accel_fs(dev, data->accel_fs);
 
 	if (res) {
@@ -287,121 +489,216 @@ static int icm42670_turn_on_sensor(const struct device *dev)
 		return res;
 	}
 
-	res = icm42670_set_gyro_odr(dev, data->gyro_hz);
+	return icm42670_set_gyro_odr(dev, data->gyro_hz);
+}
+
+#endif /* CONFIG_ICM42670_FIXED_CONFIG */
+
+static int icm42670_turn_on_sensor(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	/* configure while the outputs are still off */
+#ifdef CONFIG_ICM42670_FIXED_CONFIG
+	res = icm42670_set_fixed_config(dev);
+#else
+	res = icm42670_set_runtime_config(dev);
+#endif
 
 	if (res) {
 		return res;
 	}
 
-	/*
-	 * Accelerometer sensor need at least 10ms startup time
-	 * Gyroscope sensor need at least 30ms startup time
-	 */
-	k_msleep(100);
+	if (data->accel_avg) {
+		res = icm42670_set_accel_avg(dev, data->accel_avg);
+
+		if (res) {
+			return res;
+		}
+	}
+
+	res = icm42670_reg_update(dev, REG_PWR_MGMT0, (uint8_t)MASK_GYRO_MODE, BIT_GYRO_MODE_LNM);
+
+	if (res) {
+		return res;
+	}
+
+	k_busy_wait(MODE_SWITCH_TIME_US);
+
+	/* the accel mode depends on the rate, so it is chosen once that is set */
+	res = icm42670_update_accel_power(dev);
+
+	if (res) {
+		return res;
+	}
+
+	k_busy_wait(MODE_SWITCH_TIME_US);
+
+	/* samples taken before the start-up time has elapsed are not valid */
+	icm42670_mark_startup(&data->accel_valid_at, ACCEL_STARTUP_TIME_MS);
+	icm42670_mark_startup(&data->gyro_valid_at, GYRO_STARTUP_TIME_MS);
 
 	return 0;
 }
 
-static void icm42670_convert_accel(struct sensor_value *val, int16_t raw_val,
-				   uint16_t sensitivity_shift)
+static int icm42670_turn_off_sensor(const struct device *dev)
+{
+	/* BIT_ACCEL_MODE_OFF and BIT_GYRO_MODE_OFF */
+	return icm42670_reg_update(dev, REG_PWR_MGMT0,
+				   (uint8_t)(MASK_ACCEL_MODE | MASK_GYRO_MODE), 0);
+}
+
+int icm42670_gyro_standby(const struct device *dev, bool standby)
 {
-	/* see datasheet section 3.2 for details */
-	int64_t conv_val = ((int64_t)raw_val * SENSOR_G) >> sensitivity_shift;
+	struct icm42670_data *data = dev->data;
+	uint8_t mode = standby ? BIT_GYRO_MODE_STBY : BIT_GYRO_MODE_LNM;
+	uint8_t value;
+	int res;
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	if (data->suspended) {
+		res = -EIO;
+		goto cleanup;
+	}
+
+	res = icm42670_reg_read(dev, REG_PWR_MGMT0, &value);
+
+	if (res || (FIELD_GET(MASK_GYRO_MODE, value) == mode)) {
+		goto cleanup;
+	}
+
+	res = icm42670_reg_update(dev, REG_PWR_MGMT0, (uint8_t)MASK_GYRO_MODE, mode);
+
+	if (res || standby) {
+		goto cleanup;
+	}
 
-	val->val1 = conv_val / 1000000LL;
-	val->val2 = conv_val % 1000000LL;
+	/* the drive kept running in standby, only the output path has to settle */
+	icm42670_mark_startup(&data->gyro_valid_at, GYRO_STBY_EXIT_TIME_MS);
+
+cleanup:
+	icm42670_unlock(dev);
+	return res;
 }
 
-static void icm42670_convert_gyro(struct sensor_value *val, int16_t raw_val,
-				  uint16_t sensitivity_x10)
+/*
+ * Latest sample publication. Fetches are serialized by the driver lock and
+ * write the buffer readers are not pointed at, then flip sample_seq. Readers
+ * never wait for a writer, they only retry if a publish happened meanwhile.
+ */
+static struct icm42670_sample *icm42670_sample_begin(struct icm42670_data *data)
 {
-	/* see datasheet section 3.1 for details */
-	int64_t conv_val = ((int64_t)raw_val * SENSOR_PI * 10) / (sensitivity_x10 * 180LL);
+	atomic_val_t seq = atomic_get(&data->sample_seq);
+	struct icm42670_sample *next = &data->sample[(seq + 1) & 1];
 
-	val->val1 = conv_val / 1000000LL;
-	val->val2 = conv_val % 1000000LL;
+	/* carry over the channels this fetch does not update */
+	*next = data->sample[seq & 1];
+	next->timestamp_ns = k_ticks_to_ns_floor64(k_uptime_ticks());
+
+	return next;
 }
 
-static inline void icm42670_convert_temp(struct sensor_value *val, int16_t raw_val)
+static void icm42670_sample_publish(struct icm42670_data *data)
 {
-	/* see datasheet section 15.9 for details */
-	val->val1 = (((int64_t)raw_val * 100) / 12800) + 25;
-	val->val2 = ((((int64_t)raw_val * 100) % 12800) * 1000000) / 12800;
+	/* the new sample must be visible before readers are pointed at it */
+	barrier_dmem_fence_full();
+	atomic_inc(&data->sample_seq);
+}
 
-	if (val->val2 < 0) {
-		val->val1--;
-		val->val2 += 1000000;
-	} else if (val->val2 >= 1000000) {
-		val->val1++;
-		val->val2 -= 1000000;
-	}
+static void icm42670_sample_snapshot(struct icm42670_data *data, struct icm42670_sample *sample)
+{
+	atomic_val_t seq;
+
+	do {
+		seq = atomic_get(&data->sample_seq);
+		barrier_dmem_fence_full();
+		*sample = data->sample[seq & 1];
+		barrier_dmem_fence_full();
+	} while (seq != atomic_get(&data->sample_seq));
 }
 
 static int icm42670_channel_get(const struct device *dev, enum sensor_channel chan,
 				struct sensor_value *val)
 {
 	int res = 0;
-	const struct icm42670_data *data = dev->data;
+	struct icm42670_data *data = dev->data;
+	struct icm42670_sample sample;
 
-	icm42670_lock(dev);
+	icm42670_sample_snapshot(data, &sample);
+
+	const struct icm42670_scale *accel = icm42670_accel_scale(sample.accel_fs_sel);
+	const struct icm42670_scale *gyro = icm42670_gyro_scale(sample.gyro_fs_sel);
 
 	switch (chan) {
 	case SENSOR_CHAN_ACCEL_XYZ:
-		icm42670_convert_accel(&val[0], data->accel_x, data->accel_sensitivity_shift);
-		icm42670_convert_accel(&val[1], data->accel_y, data->accel_sensitivity_shift);
-		icm42670_convert_accel(&val[2], data->accel_z, data->accel_sensitivity_shift);
+		icm42670_convert_to_values(accel, sample.accel, val, 3);
 		break;
 	case SENSOR_CHAN_ACCEL_X:
-		icm42670_convert_accel(val, data->accel_x, data->accel_sensitivity_shift);
-		break;
 	case SENSOR_CHAN_ACCEL_Y:
-		icm42670_convert_accel(val, data->accel_y, data->accel_sensitivity_shift);
-		break;
 	case SENSOR_CHAN_ACCEL_Z:
-		icm42670_convert_accel(val, data->accel_z, data->accel_sensitivity_shift);
+		icm42670_scale_value(accel, sample.accel[chan - SENSOR_CHAN_ACCEL_X], val);
 		break;
 	case SENSOR_CHAN_GYRO_XYZ:
-		icm42670_convert_gyro(&val[0], data->gyro_x, data->gyro_sensitivity_x10);
-		icm42670_convert_gyro(&val[1], data->gyro_y, data->gyro_sensitivity_x10);
-		icm42670_convert_gyro(&val[2], data->gyro_z, data->gyro_sensitivity_x10);
+		icm42670_convert_to_values(gyro, sample.gyro, val, 3);
 		break;
 	case SENSOR_CHAN_GYRO_X:
-		icm42670_convert_gyro(val, data->gyro_x, data->gyro_sensitivity_x10);
-		break;
 	case SENSOR_CHAN_GYRO_Y:
-		icm42670_convert_gyro(val, data->gyro_y, data->gyro_sensitivity_x10);
-		break;
 	case SENSOR_CHAN_GYRO_Z:
-		icm42670_convert_gyro(val, data->gyro_z, data->gyro_sensitivity_x10);
+		icm42670_scale_value(gyro, sample.gyro[chan - SENSOR_CHAN_GYRO_X], val);
 		break;
 	case SENSOR_CHAN_DIE_TEMP:
-		icm42670_convert_temp(val, data->temp);
+		icm42670_scale_value(icm42670_temp_scale(), sample.temp, val);
 		break;
 	default:
+#ifdef CONFIG_ICM42670_APEX
+		if (chan == (enum sensor_channel)ICM42670_CHAN_STEP_COUNT) {
+			val->val1 = sample.step_count;
+			val->val2 = 0;
+			break;
+		} else if (chan == (enum sensor_channel)ICM42670_CHAN_ACTIVITY) {
+			val->val1 = sample.activity;
+			val->val2 = 0;
+			break;
+		}
+#endif
 		res = -ENOTSUP;
 		break;
 	}
 
-	icm42670_unlock(dev);
-
 	return res;
 }
 
+static void icm42670_get_axes(const uint8_t *buf, int16_t *axes)
+{
+	axes[0] = (int16_t)sys_get_be16(&buf[0]);
+	axes[1] = (int16_t)sys_get_be16(&buf[2]);
+	axes[2] = (int16_t)sys_get_be16(&buf[4]);
+}
+
 static int icm42670_sample_fetch_accel(const struct device *dev)
 {
 	const struct icm42670_config *cfg = dev->config;
 	struct icm42670_data *data = dev->data;
+	struct icm42670_sample *sample;
 	uint8_t buffer[ACCEL_DATA_SIZE];
 
-	int res = cfg->bus_io->read(&cfg->bus, REG_ACCEL_DATA_X1, buffer, ACCEL_DATA_SIZE);
+	int res = icm42670_bus_read(cfg, REG_ACCEL_DATA_X1, buffer, ACCEL_DATA_SIZE);
 
 	if (res) {
 		return res;
 	}
 
-	data->accel_x = (int16_t)sys_get_be16(&buffer[0]);
-	data->accel_y = (int16_t)sys_get_be16(&buffer[2]);
-	data->accel_z = (int16_t)sys_get_be16(&buffer[4]);
+	sample = icm42670_sample_begin(data);
+	icm42670_get_axes(buffer, sample->accel);
+	sample->accel_fs_sel = data->accel_fs_sel;
+	sample->config_gen = data->config_gen;
+	icm42670_sample_publish(data);
 
 	return 0;
 }
@@ -410,17 +707,20 @@ static int icm42670_sample_fetch_gyro(const struct device *dev)
 {
 	const struct icm42670_config *cfg = dev->config;
 	struct icm42670_data *data = dev->data;
+	struct icm42670_sample *sample;
 	uint8_t buffer[GYRO_DATA_SIZE];
 
-	int res = cfg->bus_io->read(&cfg->bus, REG_GYRO_DATA_X1, buffer, GYRO_DATA_SIZE);
+	int res = icm42670_bus_read(cfg, REG_GYRO_DATA_X1, buffer, GYRO_DATA_SIZE);
 
 	if (res) {
 		return res;
 	}
 
-	data->gyro_x = (int16_t)sys_get_be16(&buffer[0]);
-	data->gyro_y = (int16_t)sys_get_be16(&buffer[2]);
-	data->gyro_z = (int16_t)sys_get_be16(&buffer[4]);
+	sample = icm42670_sample_begin(data);
+	icm42670_get_axes(buffer, sample->gyro);
+	sample->gyro_fs_sel = data->gyro_fs_sel;
+	sample->config_gen = data->config_gen;
+	icm42670_sample_publish(data);
 
 	return 0;
 }
@@ -429,42 +729,240 @@ static int icm42670_sample_fetch_temp(const struct device *dev)
 {
 	const struct icm42670_config *cfg = dev->config;
 	struct icm42670_data *data = dev->data;
+	struct icm42670_sample *sample;
 	uint8_t buffer[TEMP_DATA_SIZE];
 
-	int res = cfg->bus_io->read(&cfg->bus, REG_TEMP_DATA1, buffer, TEMP_DATA_SIZE);
+	int res = icm42670_bus_read(cfg, REG_TEMP_DATA1, buffer, TEMP_DATA_SIZE);
 
 	if (res) {
 		return res;
 	}
 
-	data->temp = (int16_t)sys_get_be16(&buffer[0]);
+	sample = icm42670_sample_begin(data);
+	sample->temp = (int16_t)sys_get_be16(&buffer[0]);
+	icm42670_sample_publish(data);
 
 	return 0;
 }
 
-static int icm42670_sample_fetch(const struct device *dev, enum sensor_channel chan)
+static int icm42670_sample_fetch_all(const struct device *dev)
 {
-	uint8_t status;
 	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	struct icm42670_sample *sample;
+	uint8_t buffer[ALL_DATA_SIZE];
 
-	icm42670_lock(dev);
-
-	int res = cfg->bus_io->read(&cfg->bus, REG_INT_STATUS_DRDY, &status, 1);
+	/* TEMP_DATA1..GYRO_DATA_Z0 are contiguous, read them in a single burst */
+	int res = icm42670_bus_read(cfg, REG_TEMP_DATA1, buffer, ALL_DATA_SIZE);
 
 	if (res) {
-		goto cleanup;
+		return res;
 	}
 
-	if (!FIELD_GET(BIT_INT_STATUS_DATA_DRDY, status)) {
-		res = -EBUSY;
-		goto cleanup;
+	sample = icm42670_sample_begin(data);
+	sample->temp = (int16_t)sys_get_be16(&buffer[0]);
+	icm42670_get_axes(&buffer[2], sample->accel);
+	icm42670_get_axes(&buffer[8], sample->gyro);
+	sample->accel_fs_sel = data->accel_fs_sel;
+	sample->gyro_fs_sel = data->gyro_fs_sel;
+	sample->config_gen = data->config_gen;
+	icm42670_sample_publish(data);
+
+	return 0;
+}
+
+#ifdef CONFIG_ICM42670_APEX
+static int icm42670_sample_fetch_apex(const struct device *dev)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	struct icm42670_sample *sample;
+	uint8_t buffer[APEX_DATA_SIZE];
+
+	/* step count, step cadence and activity class in a single burst */
+	int res = icm42670_bus_read(cfg, REG_APEX_DATA0, buffer, APEX_DATA_SIZE);
+
+	if (res) {
+		return res;
 	}
 
-	switch (chan) {
-	case SENSOR_CHAN_ALL:
-		res |= icm42670_sample_fetch_accel(dev);
-		res |= icm42670_sample_fetch_gyro(dev);
-		res |= icm42670_sample_fetch_temp(dev);
+	sample = icm42670_sample_begin(data);
+	sample->step_count = sys_get_le16(&buffer[0]);
+	sample->activity = FIELD_GET(MASK_ACTIVITY_CLASS, buffer[3]);
+	icm42670_sample_publish(data);
+
+	return 0;
+}
+
+static bool icm42670_is_apex_channel(enum sensor_channel chan)
+{
+	return (chan == (enum sensor_channel)ICM42670_CHAN_STEP_COUNT) ||
+	       (chan == (enum sensor_channel)ICM42670_CHAN_ACTIVITY);
+}
+#endif
+
+static bool icm42670_drdy_latched(const struct device *dev)
+{
+#ifdef CONFIG_ICM42670_SKIP_DRDY_STATUS
+	struct icm42670_data *data = dev->data;
+	/* the data ready interrupt already vouched for one fresh sample */
+	return atomic_clear(&data->drdy_latched) != 0;
+#else
+	ARG_UNUSED(dev);
+
+	return false;
+#endif
+}
+
+#ifdef CONFIG_ICM42670_FETCH_WAIT
+/* sample period of the faster output */
+static int64_t icm42670_sample_period(const struct icm42670_data *data)
+{
+	uint16_t hz = MAX(MAX(data->accel_hz, data->gyro_hz), 1);
+
+	return k_us_to_ticks_ceil64(USEC_PER_SEC / hz);
+}
+
+/*
+ * Sleep until a new sample may be there, the driver lock is released
+ * meanwhile. With triggers the data ready interrupt wakes the caller, a
+ * period at most later in case the edge came before the source was routed.
+ * Without an interrupt line it sleeps until one period after the last sample
+ * seen, or a quarter period when that time has passed.
+ */
+static int icm42670_drdy_sleep(const struct device *dev, int64_t deadline)
+{
+	struct icm42670_data *data = dev->data;
+	int64_t period = icm42670_sample_period(data);
+	int64_t now = k_uptime_ticks();
+#ifdef CONFIG_ICM42670_TRIGGER
+	/*
+	 * data ready is routed to INT1 the first time a fetch waits and stays
+	 * so, instead of two INT_SOURCE0 writes around every fetch
+	 */
+	if (!data->drdy_wait_routed) {
+		int res;
+
+		data->drdy_wait_routed = true;
+		res = icm42670_trigger_update_sources(dev);
+
+		if (res) {
+			data->drdy_wait_routed = false;
+			return res;
+		}
+	}
+
+	data->drdy_waiters++;
+	k_sem_reset(&data->drdy_sem);
+
+	icm42670_unlock(dev);
+	k_sem_take(&data->drdy_sem, K_TIMEOUT_ABS_TICKS(MIN(deadline, now + period)));
+	icm42670_lock(dev);
+
+	data->drdy_waiters--;
+
+	return 0;
+#else
+	int64_t due = data->drdy_at + period;
+
+	if (due <= now) {
+		due = now + MAX(period / 4, 1);
+	}
+
+	icm42670_unlock(dev);
+	k_sleep(K_TIMEOUT_ABS_TICKS(MIN(deadline, due)));
+	icm42670_lock(dev);
+
+	return 0;
+#endif
+}
+#endif
+
+/* -EBUSY if no new sample arrives within CONFIG_ICM42670_FETCH_TIMEOUT_MS, or right away */
+static int icm42670_wait_drdy(const struct device *dev)
+{
+	const struct icm42670_config *cfg = dev->config;
+	uint8_t status;
+	int res;
+
+#ifdef CONFIG_ICM42670_FETCH_WAIT
+	struct icm42670_data *data = dev->data;
+	int64_t deadline = k_uptime_ticks() +
+			   k_ms_to_ticks_ceil64(CONFIG_ICM42670_FETCH_TIMEOUT_MS);
+#endif
+
+	while (true) {
+		res = icm42670_bus_read(cfg, REG_INT_STATUS_DRDY, &status, 1);
+
+		if (res) {
+			return res;
+		}
+
+		if (FIELD_GET(BIT_INT_STATUS_DATA_DRDY, status)) {
+#ifdef CONFIG_ICM42670_FETCH_WAIT
+			data->drdy_at = k_uptime_ticks();
+#endif
+			return 0;
+		}
+
+#ifdef CONFIG_ICM42670_FETCH_WAIT
+		if (k_uptime_ticks() < deadline) {
+			res = icm42670_drdy_sleep(dev, deadline);
+
+			if (res) {
+				return res;
+			}
+
+			continue;
+		}
+#endif
+
+		return -EBUSY;
+	}
+}
+
+static int icm42670_sample_fetch(const struct device *dev, enum sensor_channel chan)
+{
+	struct icm42670_data *data = dev->data;
+	int res = 0;
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	if (data->suspended) {
+		res = -EIO;
+		goto cleanup;
+	}
+
+#ifdef CONFIG_ICM42670_APEX
+	/* the pedometer output is not tied to the data ready flag */
+	if (icm42670_is_apex_channel(chan)) {
+		res = icm42670_sample_fetch_apex(dev);
+		goto cleanup;
+	}
+#endif
+
+	icm42670_wait_startup(dev, chan);
+
+	if (!icm42670_drdy_latched(dev)) {
+		res = icm42670_wait_drdy(dev);
+
+		if (res) {
+			goto cleanup;
+		}
+	}
+
+	switch (chan) {
+	case SENSOR_CHAN_ALL:
+		res = icm42670_sample_fetch_all(dev);
+#ifdef CONFIG_ICM42670_APEX
+		if (!res && (data->apex_active & ICM42670_APEX_PEDOMETER)) {
+			res = icm42670_sample_fetch_apex(dev);
+		}
+#endif
 		break;
 	case SENSOR_CHAN_ACCEL_XYZ:
 	case SENSOR_CHAN_ACCEL_X:
@@ -491,6 +989,157 @@ cleanup:
 	return res;
 }
 
+int icm42670_get_raw(const struct device *dev, struct icm42670_raw_sample *raw)
+{
+	struct icm42670_data *data = dev->data;
+	struct icm42670_sample sample;
+
+	if (atomic_get(&data->sample_seq) == 0) {
+		return -ENODATA;
+	}
+
+	icm42670_sample_snapshot(data, &sample);
+
+	raw->timestamp_ns = sample.timestamp_ns;
+	memcpy(raw->accel, sample.accel, sizeof(raw->accel));
+	memcpy(raw->gyro, sample.gyro, sizeof(raw->gyro));
+	raw->temp = sample.temp;
+	raw->accel_scale = *icm42670_accel_scale(sample.accel_fs_sel);
+	raw->gyro_scale = *icm42670_gyro_scale(sample.gyro_fs_sel);
+	raw->temp_scale = *icm42670_temp_scale();
+	raw->config_gen = sample.config_gen;
+
+	return 0;
+}
+
+uint16_t icm42670_config_gen(const struct device *dev)
+{
+	const struct icm42670_data *data = dev->data;
+
+	return data->config_gen;
+}
+
+int icm42670_fetch_raw(const struct device *dev, struct icm42670_raw_sample *raw)
+{
+	int res = icm42670_sample_fetch(dev, SENSOR_CHAN_ALL);
+
+	if (res) {
+		return res;
+	}
+
+	return icm42670_get_raw(dev, raw);
+}
+
+/*
+ * Full scale and sampling rates are build time constants with
+ * CONFIG_ICM42670_FIXED_CONFIG, the setters are then dropped as dead code.
+ */
+#define ICM42670_RUNTIME_CONFIG (!IS_ENABLED(CONFIG_ICM42670_FIXED_CONFIG))
+
+/*
+ * A new rate or full scale took effect. Samples taken with the previous
+ * settings must not be delivered with the new ones: the FIFO is flushed so a
+ * batch never mixes them, and register reads wait until the sample in
+ * progress and the first one with the new settings are through.
+ */
+static int icm42670_config_changed(const struct device *dev, int64_t *valid_at,
+				   uint16_t prev_hz, uint16_t hz)
+{
+	struct icm42670_data *data = dev->data;
+	int64_t settle = k_us_to_ticks_ceil64(USEC_PER_SEC / MAX(prev_hz, 1)) +
+			 k_us_to_ticks_ceil64(USEC_PER_SEC / MAX(hz, 1));
+
+	data->config_gen++;
+	*valid_at = MAX(*valid_at, k_uptime_ticks() + settle);
+
+#ifdef CONFIG_ICM42670_FIFO
+	if (data->fifo_enabled) {
+		const struct icm42670_config *cfg = dev->config;
+		int res = icm42670_bus_write(cfg, REG_SIGNAL_PATH_RESET, BIT_FIFO_FLUSH);
+
+		if (res) {
+			return res;
+		}
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+		data->tmst_fifo_empty = true;
+#endif
+	}
+#endif
+
+	return 0;
+}
+
+/* program a new accel rate and everything that follows it */
+static int icm42670_apply_accel_odr(const struct device *dev, uint16_t hz)
+{
+	struct icm42670_data *data = dev->data;
+	uint16_t prev_hz = data->accel_hz;
+	int res;
+
+	/* checked before the write, a rejected rate must not reach the device */
+	if ((data->accel_power_mode == ICM42670_ACCEL_POWER_LP) && (hz > MAX_ACCEL_LP_ODR)) {
+		LOG_ERR("Sampling frequency too high for low power mode");
+		return -ENOTSUP;
+	}
+
+	res = icm42670_set_accel_odr(dev, hz);
+
+	if (res) {
+		return res;
+	}
+
+	data->accel_hz = hz;
+	res = icm42670_config_changed(dev, &data->accel_valid_at, prev_hz, hz);
+
+	if (res) {
+		return res;
+	}
+
+	res = icm42670_update_accel_power(dev);
+#ifdef CONFIG_ICM42670_APEX
+	/* the DMP rate follows the accel rate */
+	if (!res && data->apex_active) {
+		res = icm42670_apex_update(dev);
+	}
+#endif
+
+	return res;
+}
+
+static int icm42670_apply_gyro_odr(const struct device *dev, uint16_t hz)
+{
+	struct icm42670_data *data = dev->data;
+	uint16_t prev_hz = data->gyro_hz;
+	int res = icm42670_set_gyro_odr(dev, hz);
+
+	if (res) {
+		return res;
+	}
+
+	data->gyro_hz = hz;
+
+	return icm42670_config_changed(dev, &data->gyro_valid_at, prev_hz, hz);
+}
+
+#if defined(CONFIG_ICM42670_CONSUMERS) || defined(CONFIG_ICM42670_MOTION_POLICY)
+int icm42670_set_odr(const struct device *dev, uint16_t accel_hz, uint16_t gyro_hz)
+{
+	struct icm42670_data *data = dev->data;
+	int res = 0;
+
+	if (data->accel_hz != accel_hz) {
+		res = icm42670_apply_accel_odr(dev, accel_hz);
+	}
+
+	if (!res && (data->gyro_hz != gyro_hz)) {
+		res = icm42670_apply_gyro_odr(dev, gyro_hz);
+	}
+
+	return res;
+}
+#endif
+
 static int icm42670_attr_set(const struct device *dev, enum sensor_channel chan,
 			     enum sensor_attribute attr, const struct sensor_value *val)
 {
@@ -499,6 +1148,10 @@ static int icm42670_attr_set(const struct device *dev, enum sensor_channel chan,
 
 	__ASSERT_NO_MSG(val != NULL);
 
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
 	icm42670_lock(dev);
 
 	switch (chan) {
@@ -506,22 +1159,57 @@ static int icm42670_attr_set(const struct device *dev, enum sensor_channel chan,
 	case SENSOR_CHAN_ACCEL_Y:
 	case SENSOR_CHAN_ACCEL_Z:
 	case SENSOR_CHAN_ACCEL_XYZ:
-		if (attr == SENSOR_ATTR_SAMPLING_FREQUENCY) {
-			res = icm42670_set_accel_odr(dev, data->accel_hz);
+		if (ICM42670_RUNTIME_CONFIG && (attr == SENSOR_ATTR_SAMPLING_FREQUENCY)) {
+			if (icm42670_rate_owned(data)) {
+				res = -EBUSY;
+				break;
+			}
+
+			res = icm42670_apply_accel_odr(dev, val->val1);
 
 			if (res) {
 				LOG_ERR("Incorrect sampling value");
-			} else {
-				data->accel_hz = val->val1;
 			}
-		} else if (attr == SENSOR_ATTR_FULL_SCALE) {
-			res = icm42670_set_accel_fs(dev, data->accel_fs);
+		} else if (ICM42670_RUNTIME_CONFIG && (attr == SENSOR_ATTR_FULL_SCALE)) {
+			res = icm42670_set_accel_fs(dev, val->val1);
 
 			if (res) {
 				LOG_ERR("Incorrect fullscale value");
 			} else {
 				data->accel_fs = val->val1;
+				res = icm42670_config_changed(dev, &data->accel_valid_at,
+							      data->accel_hz, data->accel_hz);
+			}
+		} else if (attr == SENSOR_ATTR_OVERSAMPLING) {
+			res = icm42670_set_accel_avg(dev, val->val1);
+
+			if (res) {
+				LOG_ERR("Incorrect oversampling value");
+			} else {
+				res = icm42670_update_accel_power(dev);
+			}
+		} else if (attr == (enum sensor_attribute)ICM42670_ATTR_ACCEL_POWER_MODE) {
+			uint8_t prev = data->accel_power_mode;
+
+			if ((val->val1 < ICM42670_ACCEL_POWER_AUTO) ||
+			    (val->val1 > ICM42670_ACCEL_POWER_LP)) {
+				LOG_ERR("Incorrect power mode");
+				res = -EINVAL;
+				break;
+			}
+
+			data->accel_power_mode = val->val1;
+			res = icm42670_update_accel_power(dev);
+
+			if (res) {
+				data->accel_power_mode = prev;
 			}
+#ifdef CONFIG_ICM42670_TRIGGER
+		} else if (attr == SENSOR_ATTR_SLOPE_TH) {
+			res = icm42670_trigger_set_wom_threshold(dev, chan, val);
+		} else if (attr == SENSOR_ATTR_SLOPE_DUR) {
+			res = icm42670_trigger_set_wom_duration(dev, val);
+#endif
 		} else {
 			LOG_ERR("Unsupported attribute");
 			res = -ENOTSUP;
@@ -532,21 +1220,26 @@ static int icm42670_attr_set(const struct device *dev, enum sensor_channel chan,
 	case SENSOR_CHAN_GYRO_Y:
 	case SENSOR_CHAN_GYRO_Z:
 	case SENSOR_CHAN_GYRO_XYZ:
-		if (attr == SENSOR_ATTR_SAMPLING_FREQUENCY) {
-			res = icm42670_set_gyro_odr(dev, data->gyro_hz);
+		if (ICM42670_RUNTIME_CONFIG && (attr == SENSOR_ATTR_SAMPLING_FREQUENCY)) {
+			if (icm42670_rate_owned(data)) {
+				res = -EBUSY;
+				break;
+			}
+
+			res = icm42670_apply_gyro_odr(dev, val->val1);
 
 			if (res) {
 				LOG_ERR("Incorrect sampling value");
-			} else {
-				data->gyro_hz = val->val1;
 			}
-		} else if (attr == SENSOR_ATTR_FULL_SCALE) {
-			res = icm42670_set_gyro_fs(dev, data->gyro_fs);
+		} else if (ICM42670_RUNTIME_CONFIG && (attr == SENSOR_ATTR_FULL_SCALE)) {
+			res = icm42670_set_gyro_fs(dev, val->val1);
 
 			if (res) {
 				LOG_ERR("Incorrect fullscale value");
 			} else {
 				data->gyro_fs = val->val1;
+				res = icm42670_config_changed(dev, &data->gyro_valid_at,
+							      data->gyro_hz, data->gyro_hz);
 			}
 		} else {
 			LOG_ERR("Unsupported attribute");
@@ -554,6 +1247,41 @@ static int icm42670_attr_set(const struct device *dev, enum sensor_channel chan,
 		}
 		break;
 
+	case SENSOR_CHAN_ALL:
+#ifdef CONFIG_ICM42670_FIFO
+		if (attr == SENSOR_ATTR_BATCH_DURATION) {
+			/* batch duration is given in ticks, the watermark in samples */
+			uint32_t odr = MAX(data->accel_hz, data->gyro_hz);
+			uint64_t records = ((uint64_t)val->val1 * odr) /
+					   CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+
+			res = icm42670_fifo_set_watermark(dev, (uint16_t)MIN(records, UINT16_MAX));
+			break;
+		}
+#endif
+#ifdef CONFIG_ICM42670_APEX
+		if (attr == SENSOR_ATTR_FEATURE_MASK) {
+			uint8_t prev = data->apex_features;
+
+			if (val->val1 & ~ICM42670_APEX_ALL) {
+				LOG_ERR("Incorrect feature mask");
+				res = -EINVAL;
+				break;
+			}
+
+			data->apex_features = val->val1;
+			res = icm42670_apex_update(dev);
+
+			if (res) {
+				data->apex_features = prev;
+			}
+			break;
+		}
+#endif
+		LOG_ERR("Unsupported attribute");
+		res = -EINVAL;
+		break;
+
 	default:
 		LOG_ERR("Unsupported channel");
 		res = -EINVAL;
@@ -584,6 +1312,19 @@ static int icm42670_attr_get(const struct device *dev, enum sensor_channel chan,
 			val->val1 = data->accel_hz;
 		} else if (attr == SENSOR_ATTR_FULL_SCALE) {
 			val->val1 = data->accel_fs;
+		} else if (attr == SENSOR_ATTR_OVERSAMPLING) {
+			val->val1 = data->accel_avg;
+			val->val2 = 0;
+		} else if (attr == (enum sensor_attribute)ICM42670_ATTR_ACCEL_POWER_MODE) {
+			val->val1 = data->accel_power_active;
+			val->val2 = 0;
+#ifdef CONFIG_ICM42670_TRIGGER
+		} else if (attr == SENSOR_ATTR_SLOPE_TH) {
+			icm42670_trigger_get_wom_threshold(dev, chan, val);
+		} else if (attr == SENSOR_ATTR_SLOPE_DUR) {
+			val->val1 = data->wom_dur + 1;
+			val->val2 = 0;
+#endif
 		} else {
 			LOG_ERR("Unsupported attribute");
 			res = -EINVAL;
@@ -604,6 +1345,27 @@ static int icm42670_attr_get(const struct device *dev, enum sensor_channel chan,
 		}
 		break;
 
+	case SENSOR_CHAN_ALL:
+#ifdef CONFIG_ICM42670_FIFO
+		if (attr == SENSOR_ATTR_BATCH_DURATION) {
+			uint32_t odr = MAX(data->accel_hz, data->gyro_hz);
+
+			val->val1 = ((uint64_t)data->fifo_wm * CONFIG_SYS_CLOCK_TICKS_PER_SEC) / odr;
+			val->val2 = 0;
+			break;
+		}
+#endif
+#ifdef CONFIG_ICM42670_APEX
+		if (attr == SENSOR_ATTR_FEATURE_MASK) {
+			val->val1 = data->apex_active;
+			val->val2 = 0;
+			break;
+		}
+#endif
+		LOG_ERR("Unsupported attribute");
+		res = -EINVAL;
+		break;
+
 	default:
 		LOG_ERR("Unsupported channel");
 		res = -EINVAL;
@@ -622,6 +1384,141 @@ static inline int icm42670_bus_check(const struct device *dev)
 	return cfg->bus_io->check(&cfg->bus);
 }
 
+static int icm42670_pm_action(const struct device *dev, enum pm_device_action action)
+{
+	struct icm42670_data *data = dev->data;
+	int res = 0;
+
+	icm42670_lock(dev);
+
+	/* a power-up still in progress applies the state once it gets to the outputs */
+	switch (action) {
+	case PM_DEVICE_ACTION_RESUME:
+		if (icm42670_is_ready(dev)) {
+			res = icm42670_turn_on_sensor(dev);
+		}
+
+		if (!res) {
+			data->suspended = false;
+		}
+
+#ifdef CONFIG_ICM42670_MOTION_POLICY
+		if (!res) {
+			res = icm42670_policy_resume(dev);
+		}
+#endif
+		break;
+
+	case PM_DEVICE_ACTION_SUSPEND:
+		if (icm42670_is_ready(dev)) {
+			res = icm42670_turn_off_sensor(dev);
+		}
+
+		if (!res) {
+			data->suspended = true;
+#ifdef CONFIG_ICM42670_MOTION_POLICY
+			icm42670_policy_suspend(dev);
+#endif
+		}
+		break;
+
+	default:
+		res = -ENOTSUP;
+		break;
+	}
+
+	icm42670_unlock(dev);
+
+	return res;
+}
+
+#ifdef CONFIG_ICM42670_DEFERRED_INIT
+
+enum icm42670_init_step {
+	ICM42670_INIT_RESET,
+	ICM42670_INIT_CONFIGURE,
+};
+
+/* runs the power-up sequence from the system work queue, one step per delay */
+static void icm42670_init_work_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct icm42670_data *data = CONTAINER_OF(dwork, struct icm42670_data, init_work);
+	const struct device *dev = data->dev;
+	int res;
+
+	switch (data->init_step) {
+	case ICM42670_INIT_RESET:
+		res = icm42670_sensor_reset(dev);
+
+		if (!res) {
+			data->init_step = ICM42670_INIT_CONFIGURE;
+			k_work_schedule(dwork, K_MSEC(SOFT_RESET_TIME_MS));
+		}
+		break;
+
+	case ICM42670_INIT_CONFIGURE:
+		res = icm42670_sensor_configure(dev);
+
+		if (res) {
+			break;
+		}
+
+		/* serialized with PM actions, which only record the state until ready */
+		icm42670_lock(dev);
+
+		if (!data->suspended) {
+			res = icm42670_turn_on_sensor(dev);
+		}
+
+#ifdef CONFIG_ICM42670_TRIGGER
+		if (!res) {
+			res = icm42670_trigger_enable_interrupt(dev);
+		}
+#endif
+
+		/* fetches wait out the remaining start-up time themselves */
+		if (!res) {
+			LOG_DBG("%s ready", dev->name);
+			k_event_post(&data->init_event, ICM42670_INIT_READY);
+		}
+
+		icm42670_unlock(dev);
+		break;
+
+	default:
+		res = -EINVAL;
+		break;
+	}
+
+	if (res) {
+		LOG_ERR("could not initialize sensor (%d)", res);
+		k_event_post(&data->init_event, ICM42670_INIT_FAILED);
+	}
+}
+
+#endif /* CONFIG_ICM42670_DEFERRED_INIT */
+
+int icm42670_wait_ready(const struct device *dev, k_timeout_t timeout)
+{
+#ifdef CONFIG_ICM42670_DEFERRED_INIT
+	struct icm42670_data *data = dev->data;
+	uint32_t events = k_event_wait(&data->init_event,
+				       ICM42670_INIT_READY | ICM42670_INIT_FAILED, false, timeout);
+
+	if (events & ICM42670_INIT_FAILED) {
+		return -EIO;
+	}
+
+	return (events & ICM42670_INIT_READY) ? 0 : -EAGAIN;
+#else
+	ARG_UNUSED(dev);
+	ARG_UNUSED(timeout);
+
+	return 0;
+#endif
+}
+
 static int icm42670_init(const struct device *dev)
 {
 	struct icm42670_data *data = dev->data;
@@ -631,18 +1528,24 @@ static int icm42670_init(const struct device *dev)
 		return -ENODEV;
 	}
 
-	data->accel_x = 0;
-	data->accel_y = 0;
-	data->accel_z = 0;
-	data->gyro_x = 0;
-	data->gyro_y = 0;
-	data->gyro_z = 0;
-	data->temp = 0;
+	data->dev = dev;
+	k_mutex_init(&data->mutex);
+	memset(data->sample, 0, sizeof(data->sample));
+	atomic_set(&data->sample_seq, 0);
 
+#ifdef CONFIG_ICM42670_DEFERRED_INIT
+	k_event_init(&data->init_event);
+	k_work_init_delayable(&data->init_work, icm42670_init_work_handler);
+#else
 	if (icm42670_sensor_init(dev)) {
 		LOG_ERR("could not initialize sensor");
 		return -EIO;
 	}
+#endif
+
+#ifdef CONFIG_SENSOR_ASYNC_API
+	icm42670_rtio_init(dev);
+#endif
 
 #ifdef CONFIG_ICM42670_TRIGGER
 	if (icm42670_trigger_init(dev)) {
@@ -651,7 +1554,19 @@ static int icm42670_init(const struct device *dev)
 	}
 #endif
 
-	int res = icm42670_turn_on_sensor(dev);
+#ifdef CONFIG_ICM42670_DEFERRED_INIT
+	/* the sensor is brought up in the background, see icm42670_wait_ready() */
+	data->init_step = ICM42670_INIT_RESET;
+	k_work_schedule(&data->init_work, K_MSEC(POWER_UP_TIME_MS));
+
+	return 0;
+#else
+	/* turns the outputs on, unless runtime PM is to do so on first use */
+	int res = pm_device_driver_init(dev, icm42670_pm_action);
+
+	if (res) {
+		return res;
+	}
 
 #ifdef CONFIG_ICM42670_TRIGGER
 	if (icm42670_trigger_enable_interrupt(dev)) {
@@ -660,22 +1575,23 @@ static int icm42670_init(const struct device *dev)
 	}
 #endif
 
-	return res;
+	return 0;
+#endif
 }
 
-#ifndef CONFIG_ICM42670_TRIGGER
-
 void icm42670_lock(const struct device *dev)
 {
-	ARG_UNUSED(dev);
+	struct icm42670_data *data = dev->data;
+
+	k_mutex_lock(&data->mutex, K_FOREVER);
 }
 
 void icm42670_unlock(const struct device *dev)
 {
-	ARG_UNUSED(dev);
-}
+	struct icm42670_data *data = dev->data;
 
-#endif
+	k_mutex_unlock(&data->mutex);
+}
 
 static const struct sensor_driver_api icm42670_driver_api = {
 #ifdef CONFIG_ICM42670_TRIGGER
@@ -685,21 +1601,81 @@ static const struct sensor_driver_api icm42670_driver_api = {
 	.channel_get = icm42670_channel_get,
 	.attr_set = icm42670_attr_set,
 	.attr_get = icm42670_attr_get,
+#ifdef CONFIG_SENSOR_ASYNC_API
+	.submit = icm42670_submit,
+	.get_decoder = icm42670_get_decoder,
+#endif
 };
 
+#ifdef CONFIG_ICM42670_SHELL
+bool icm42670_is_instance(const struct device *dev)
+{
+	return dev->api == &icm42670_driver_api;
+}
+#endif
+
 /* device defaults to spi mode 0/3 support */
 #define ICM42670_SPI_CFG                                                                           \
 	SPI_OP_MODE_MASTER | SPI_MODE_CPOL | SPI_MODE_CPHA | SPI_WORD_SET(8) | SPI_TRANSFER_MSB
 
+#ifdef CONFIG_ICM42670_BUS_STATS
+/* every access goes through the instrumented bus_io, which forwards to the real one */
+#define ICM42670_BUS_IO(inst, io)                                                                  \
+	.bus_io = &icm42670_bus_io_stats,                                                          \
+	.bus_io_raw = &(io),                                                                       \
+	.bus_monitor = &icm42670_driver_##inst.bus_monitor,
+#else
+#define ICM42670_BUS_IO(inst, io) .bus_io = &(io),
+#endif
+
 /* Initializes the bus members for an instance on a SPI bus. */
 #define ICM42670_CONFIG_SPI(inst)                                                                  \
 	.bus.spi = SPI_DT_SPEC_INST_GET(inst, ICM42670_SPI_CFG, 0),                                \
-	.bus_io = &icm42670_bus_io_spi,
+	ICM42670_BUS_IO(inst, icm42670_bus_io_spi)
 
 /* Initializes the bus members for an instance on an I2C bus. */
 #define ICM42670_CONFIG_I2C(inst)                                                                  \
 	.bus.i2c = I2C_DT_SPEC_INST_GET(inst),                                                     \
-	.bus_io = &icm42670_bus_io_i2c,
+	ICM42670_BUS_IO(inst, icm42670_bus_io_i2c)
+
+#ifdef CONFIG_ICM42670_FIXED_CONFIG
+/* register fields of the devicetree settings, picked like the runtime setters do */
+#define ICM42670_ACCEL_FS_SEL(fs)                                                                  \
+	((fs) > 8 ? BIT_ACCEL_UI_FS_16 : (fs) > 4 ? BIT_ACCEL_UI_FS_8 :                            \
+	 (fs) > 2 ? BIT_ACCEL_UI_FS_4 : BIT_ACCEL_UI_FS_2)
+
+#define ICM42670_GYRO_FS_SEL(fs)                                                                   \
+	((fs) > 1000 ? BIT_GYRO_UI_FS_2000 : (fs) > 500 ? BIT_GYRO_UI_FS_1000 :                    \
+	 (fs) > 250 ? BIT_GYRO_UI_FS_500 : BIT_GYRO_UI_FS_250)
+
+#define ICM42670_ACCEL_ODR(hz)                                                                     \
+	((hz) > 800 ? BIT_ACCEL_ODR_1600 : (hz) > 400 ? BIT_ACCEL_ODR_800 :                        \
+	 (hz) > 200 ? BIT_ACCEL_ODR_400 : (hz) > 100 ? BIT_ACCEL_ODR_200 :                         \
+	 (hz) > 50 ? BIT_ACCEL_ODR_100 : (hz) > 25 ? BIT_ACCEL_ODR_50 :                            \
+	 (hz) > 12 ? BIT_ACCEL_ODR_25 : (hz) > 6 ? BIT_ACCEL_ODR_12 :                              \
+	 (hz) > 3 ? BIT_ACCEL_ODR_6 : (hz) > 1 ? BIT_ACCEL_ODR_3 : BIT_ACCEL_ODR_1)
+
+#define ICM42670_GYRO_ODR(hz)                                                                      \
+	((hz) > 800 ? BIT_GYRO_ODR_1600 : (hz) > 400 ? BIT_GYRO_ODR_800 :                          \
+	 (hz) > 200 ? BIT_GYRO_ODR_400 : (hz) > 100 ? BIT_GYRO_ODR_200 :                           \
+	 (hz) > 50 ? BIT_GYRO_ODR_100 : (hz) > 25 ? BIT_GYRO_ODR_50 :                              \
+	 (hz) > 12 ? BIT_GYRO_ODR_25 : BIT_GYRO_ODR_12)
+
+#define ICM42670_FIXED_CONFIG(inst)                                                                \
+	.accel_config0 =                                                                           \
+		FIELD_PREP(MASK_ACCEL_UI_FS_SEL, ICM42670_ACCEL_FS_SEL(DT_INST_PROP(inst, accel_fs))) | \
+		FIELD_PREP(MASK_ACCEL_ODR, ICM42670_ACCEL_ODR(DT_INST_PROP(inst, accel_hz))),     \
+	.gyro_config0 =                                                                            \
+		FIELD_PREP(MASK_GYRO_UI_FS_SEL, ICM42670_GYRO_FS_SEL(DT_INST_PROP(inst, gyro_fs))) | \
+		FIELD_PREP(MASK_GYRO_ODR, ICM42670_GYRO_ODR(DT_INST_PROP(inst, gyro_hz))),
+#endif
+
+/*
+ * wake on motion threshold in 1g/256 units from the devicetree value in mg,
+ * a threshold of 0 would wake on every sample
+ */
+#define ICM42670_WOM_THR(inst)                                                                     \
+	CLAMP(DT_INST_PROP(inst, wom_threshold_mg) * WOM_THR_PER_G / 1000, 1, UINT8_MAX)
 
 #define ICM42670_INIT(inst)                                                                        \
 	static struct icm42670_data icm42670_driver_##inst = {                                     \
@@ -707,6 +1683,11 @@ static const struct sensor_driver_api icm42670_driver_api = {
 		.accel_fs = DT_INST_PROP(inst, accel_fs),                                          \
 		.gyro_hz = DT_INST_PROP(inst, gyro_hz),                                            \
 		.gyro_fs = DT_INST_PROP(inst, gyro_fs),                                            \
+		IF_ENABLED(CONFIG_ICM42670_FIFO,                                                   \
+			   (.fifo_wm = DT_INST_PROP(inst, fifo_watermark),))                       \
+		IF_ENABLED(CONFIG_ICM42670_TRIGGER,                                                \
+			   (.wom_thr = { ICM42670_WOM_THR(inst), ICM42670_WOM_THR(inst),           \
+					 ICM42670_WOM_THR(inst) },))                               \
 	};                                                                                         \
                                                                                                    \
 	static const struct icm42670_config icm42670_cfg_##inst = {                                \
@@ -714,10 +1695,13 @@ static const struct sensor_driver_api icm42670_driver_api = {
 			(ICM42670_CONFIG_SPI(inst)),                                               \
 			(ICM42670_CONFIG_I2C(inst)))                                               \
 		.gpio_int = GPIO_DT_SPEC_INST_GET_OR(inst, int_gpios, {0}),                        \
+		IF_ENABLED(CONFIG_ICM42670_FIXED_CONFIG, (ICM42670_FIXED_CONFIG(inst)))            \
 	};                                                                                         \
                                                                                                    \
-	SENSOR_DEVICE_DT_INST_DEFINE(inst, icm42670_init, NULL, &icm42670_driver_##inst,           \
-			      &icm42670_cfg_##inst, POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY,      \
-			      &icm42670_driver_api);
+	PM_DEVICE_DT_INST_DEFINE(inst, icm42670_pm_action);                                        \
+                                                                                                   \
+	SENSOR_DEVICE_DT_INST_DEFINE(inst, icm42670_init, PM_DEVICE_DT_INST_GET(inst),             \
+				     &icm42670_driver_##inst, &icm42670_cfg_##inst, POST_KERNEL,   \
+				     CONFIG_SENSOR_INIT_PRIORITY, &icm42670_driver_api);
 
 DT_INST_FOREACH_STATUS_OKAY(ICM42670_INIT)
@@ -13,6 +13,9 @@
 #include <zephyr/drivers/spi.h>
 #include <zephyr/drivers/i2c.h>
 #include <zephyr/kernel.h>
+#include <zephyr/sys/mpsc_lockfree.h>
+#include <app/drivers/sensor/icm42670.h>
+#include "icm42670_tmst.h"
 
 #define ICM42670_BUS_SPI DT_HAS_COMPAT_ON_BUS_STATUS_OKAY(invensense_icm42670_temp, spi)
 #define ICM42670_BUS_I2C DT_HAS_COMPAT_ON_BUS_STATUS_OKAY(invensense_icm42670_temp, i2c)
@@ -32,6 +35,9 @@ typedef int (*icm42670_reg_read_fn)(const union icm42670_bus *bus,
 typedef int (*icm42670_reg_write_fn)(const union icm42670_bus *bus,
 				   uint16_t reg, uint8_t data);
 
+typedef int (*icm42670_reg_write_block_fn)(const union icm42670_bus *bus,
+					 uint16_t reg, const uint8_t *data, size_t size);
+
 typedef int (*icm42670_reg_update_fn)(const union icm42670_bus *bus,
 				   uint16_t reg, uint8_t mask, uint8_t data);
 
@@ -39,37 +45,204 @@ struct icm42670_bus_io {
 	icm42670_bus_check_fn check;
 	icm42670_reg_read_fn read;
 	icm42670_reg_write_fn write;
+	icm42670_reg_write_block_fn write_block;
 	icm42670_reg_update_fn update;
 };
 
 #if ICM42670_BUS_SPI
 extern const struct icm42670_bus_io icm42670_bus_io_spi;
+
+int icm42670_spi_read(const union icm42670_bus *bus, uint16_t reg, uint8_t *data, size_t len);
+int icm42670_spi_write(const union icm42670_bus *bus, uint16_t reg, const uint8_t *data,
+		       size_t len);
+int icm42670_spi_single_write(const union icm42670_bus *bus, uint16_t reg, uint8_t data);
+int icm42670_spi_update_register(const union icm42670_bus *bus, uint16_t reg, uint8_t mask,
+				 uint8_t data);
 #endif
 
 #if ICM42670_BUS_I2C
 extern const struct icm42670_bus_io icm42670_bus_io_i2c;
+
+int icm42670_reg_read_i2c(const union icm42670_bus *bus, uint16_t reg, uint8_t *data,
+			  size_t len);
+int icm42670_reg_write_block_i2c(const union icm42670_bus *bus, uint16_t reg,
+				 const uint8_t *data, size_t len);
+int icm42670_reg_write_i2c(const union icm42670_bus *bus, uint16_t reg, uint8_t data);
+int icm42670_reg_update_i2c(const union icm42670_bus *bus, uint16_t reg, uint8_t mask,
+			    uint8_t val);
+#endif
+
+/* with every instance on the same bus type, bus access can skip the bus_io table */
+#if defined(CONFIG_ICM42670_BUS_DIRECT) && ICM42670_BUS_SPI && !ICM42670_BUS_I2C
+#define ICM42670_BUS_DIRECT_SPI 1
+#elif defined(CONFIG_ICM42670_BUS_DIRECT) && ICM42670_BUS_I2C && !ICM42670_BUS_SPI
+#define ICM42670_BUS_DIRECT_I2C 1
+#endif
+
+#ifdef CONFIG_ICM42670_BUS_STATS
+/* bus statistics of one instance, updated by icm42670_bus_io_stats */
+struct icm42670_bus_monitor {
+	struct k_spinlock lock;
+	struct icm42670_bus_stats stats;
+};
+
+extern const struct icm42670_bus_io icm42670_bus_io_stats;
+#endif
+
+#ifdef CONFIG_ICM42670_APEX
+/* APEX engine events, bit n of the feature mask enables event n */
+enum icm42670_apex_event {
+	ICM42670_APEX_EV_STEP,
+	ICM42670_APEX_EV_TILT,
+	ICM42670_APEX_EV_SMD,
+	ICM42670_APEX_EV_FREEFALL,
+	ICM42670_APEX_EV_COUNT,
+};
+
+struct icm42670_apex_handler {
+	sensor_trigger_handler_t handler;
+	const struct sensor_trigger *trigger;
+};
 #endif
 
+/* latest fetched sample, with the scale it was taken at */
+struct icm42670_sample {
+	uint64_t timestamp_ns;
+	int16_t accel[3];
+	int16_t gyro[3];
+	int16_t temp;
+	uint8_t accel_fs_sel;
+	uint8_t gyro_fs_sel;
+	uint16_t config_gen;
+#ifdef CONFIG_ICM42670_APEX
+	uint16_t step_count;
+	uint8_t activity;
+#endif
+};
+
+/* number of registers in the shadow cache, see icm42670_cache.c */
+#define ICM42670_REG_CACHE_SIZE 54
+
 struct icm42670_data {
-	int16_t accel_x;
-	int16_t accel_y;
-	int16_t accel_z;
-	uint16_t accel_sensitivity_shift;
+	const struct device *dev;
+	uint8_t reg_cache[ICM42670_REG_CACHE_SIZE];
+	uint64_t reg_cache_valid;
+	struct icm42670_sample sample[2];
+	atomic_t sample_seq;
+#ifdef CONFIG_ICM42670_BUS_STATS
+	struct icm42670_bus_monitor bus_monitor;
+#endif
 	uint16_t accel_hz;
 	uint16_t accel_fs;
-	int16_t gyro_x;
-	int16_t gyro_y;
-	int16_t gyro_z;
-	uint16_t gyro_sensitivity_x10;
 	uint16_t gyro_hz;
 	uint16_t gyro_fs;
-	int16_t temp;
+	/* FS_SEL field values, select the conversion constants in icm42670_convert.c */
+	uint8_t accel_fs_sel;
+	uint8_t gyro_fs_sel;
+	/* bumped on every rate or full scale change, tags the samples delivered */
+	uint16_t config_gen;
+	/* requested and effective accel power mode, enum icm42670_accel_power_mode */
+	uint8_t accel_power_mode;
+	uint8_t accel_power_active;
+	/* low power mode averaging in samples, 0 until a noise budget is given */
+	uint8_t accel_avg;
+	/* uptime in ticks at which the outputs turned on last produce valid data */
+	int64_t accel_valid_at;
+	int64_t gyro_valid_at;
+	/* outputs are off until a PM resume */
+	bool suspended;
+	struct k_mutex mutex;
+#ifdef CONFIG_ICM42670_FETCH_WAIT
+	/* uptime in ticks at which a fetch last found a new sample */
+	int64_t drdy_at;
+#endif
+#ifdef CONFIG_ICM42670_APEX
+	/* features requested through the feature mask attribute, and in effect */
+	uint8_t apex_features;
+	uint8_t apex_active;
+	bool dmp_started;
+#endif
+#ifdef CONFIG_ICM42670_DEFERRED_INIT
+	struct k_work_delayable init_work;
+	struct k_event init_event;
+	uint8_t init_step;
+#endif
+#ifdef CONFIG_ICM42670_FIFO
+	bool fifo_enabled;
+	/* ICM42670_FIFO_OWNER_* the FIFO was started for, stopped with the last one */
+	uint8_t fifo_owners;
+	uint8_t fifo_packet_size;
+	uint16_t fifo_wm;
+	uint8_t fifo_buf[CONFIG_ICM42670_FIFO_BUF_SIZE];
+#endif
+#ifdef CONFIG_ICM42670_CONSUMERS
+	sys_slist_t consumers;
+	struct icm42670_fifo_frame consumer_frames[CONFIG_ICM42670_CONSUMER_BATCH];
+#endif
+#ifdef CONFIG_ICM42670_MOTION_POLICY
+	struct icm42670_motion_policy policy;
+	struct k_work_delayable policy_work;
+	bool policy_running;
+	/* wake on motion seen by the interrupt thread since the last check */
+	bool policy_motion;
+	/* current profile, enum icm42670_motion_profile, and since when in uptime ms */
+	uint8_t profile;
+	int64_t profile_since;
+	uint64_t profile_ms[ICM42670_PROFILE_COUNT];
+	uint32_t policy_wakeups;
+	/* settings to go back to when the policy stops */
+	uint8_t policy_prev_power_mode;
+	uint16_t policy_prev_accel_hz;
+	uint16_t policy_prev_gyro_hz;
+#endif
+#ifdef CONFIG_ICM42670_TIMESTAMP
+	struct icm42670_tmst tmst;
+	bool tmst_fifo_empty;
+#ifdef CONFIG_ICM42670_TRIGGER
+	/* written by the interrupt, 64-bit accesses are not atomic on every target */
+	struct k_spinlock irq_lock;
+	uint64_t irq_ns;
+#endif
+#endif
+#ifdef CONFIG_SENSOR_ASYNC_API
+	struct mpsc rtio_queue;
+	struct k_work rtio_work;
+#endif
+#ifdef CONFIG_ICM42670_STREAM
+	struct rtio_iodev_sqe *streaming_sqe;
+	enum sensor_stream_data_opt stream_fifo_opt;
+	enum sensor_stream_data_opt stream_drdy_opt;
+	uint8_t stream_sources;
+#endif
 #ifdef CONFIG_ICM42670_TRIGGER
-	const struct device *dev;
 	struct gpio_callback gpio_cb;
 	sensor_trigger_handler_t data_ready_handler;
 	const struct sensor_trigger *data_ready_trigger;
-	struct k_mutex mutex;
+	sensor_trigger_handler_t motion_handler;
+	const struct sensor_trigger *motion_trigger;
+	/* wake on motion thresholds in 1g/256 units for X, Y and Z, and duration - 1 */
+	uint8_t wom_thr[3];
+	uint8_t wom_dur;
+	uint8_t int_sources;
+#ifdef CONFIG_ICM42670_APEX
+	struct icm42670_apex_handler apex_handlers[ICM42670_APEX_EV_COUNT];
+#endif
+#ifdef CONFIG_ICM42670_SKIP_DRDY_STATUS
+	atomic_t drdy_latched;
+#endif
+#ifdef CONFIG_ICM42670_FETCH_WAIT
+	/* fetches sleeping until the data ready interrupt */
+	struct k_sem drdy_sem;
+	uint8_t drdy_waiters;
+	/* data ready stays routed to INT1 once a fetch waited for it */
+	bool drdy_wait_routed;
+#endif
+#ifdef CONFIG_ICM42670_FIFO
+	sensor_trigger_handler_t fifo_wm_handler;
+	const struct sensor_trigger *fifo_wm_trigger;
+	sensor_trigger_handler_t fifo_full_handler;
+	const struct sensor_trigger *fifo_full_trigger;
+#endif
 #endif
 #ifdef CONFIG_ICM42670_TRIGGER_OWN_THREAD
 	K_KERNEL_STACK_MEMBER(thread_stack, CONFIG_ICM42670_THREAD_STACK_SIZE);
@@ -84,7 +257,175 @@ struct icm42670_data {
 struct icm42670_config {
 	union icm42670_bus bus;
 	const struct icm42670_bus_io *bus_io;
+#ifdef CONFIG_ICM42670_BUS_STATS
+	/* the SPI or I2C bus_io the instrumented one forwards to */
+	const struct icm42670_bus_io *bus_io_raw;
+	struct icm42670_bus_monitor *bus_monitor;
+#endif
 	struct gpio_dt_spec gpio_int;
+#ifdef CONFIG_ICM42670_FIXED_CONFIG
+	/* ACCEL_CONFIG0 and GYRO_CONFIG0 values of the devicetree settings */
+	uint8_t accel_config0;
+	uint8_t gyro_config0;
+#endif
 };
 
+/* register access of an instance, through bus_io or resolved at build time */
+static inline int icm42670_bus_read(const struct icm42670_config *cfg, uint16_t reg,
+				    uint8_t *data, size_t len)
+{
+#if defined(ICM42670_BUS_DIRECT_SPI)
+	return icm42670_spi_read(&cfg->bus, reg, data, len);
+#elif defined(ICM42670_BUS_DIRECT_I2C)
+	return icm42670_reg_read_i2c(&cfg->bus, reg, data, len);
+#else
+	return cfg->bus_io->read(&cfg->bus, reg, data, len);
+#endif
+}
+
+static inline int icm42670_bus_write(const struct icm42670_config *cfg, uint16_t reg,
+				     uint8_t data)
+{
+#if defined(ICM42670_BUS_DIRECT_SPI)
+	return icm42670_spi_single_write(&cfg->bus, reg, data);
+#elif defined(ICM42670_BUS_DIRECT_I2C)
+	return icm42670_reg_write_i2c(&cfg->bus, reg, data);
+#else
+	return cfg->bus_io->write(&cfg->bus, reg, data);
+#endif
+}
+
+static inline int icm42670_bus_write_block(const struct icm42670_config *cfg, uint16_t reg,
+					   const uint8_t *data, size_t len)
+{
+#if defined(ICM42670_BUS_DIRECT_SPI)
+	return icm42670_spi_write(&cfg->bus, reg, data, len);
+#elif defined(ICM42670_BUS_DIRECT_I2C)
+	return icm42670_reg_write_block_i2c(&cfg->bus, reg, data, len);
+#else
+	return cfg->bus_io->write_block(&cfg->bus, reg, data, len);
+#endif
+}
+
+static inline int icm42670_bus_update(const struct icm42670_config *cfg, uint16_t reg,
+				      uint8_t mask, uint8_t data)
+{
+#if defined(ICM42670_BUS_DIRECT_SPI)
+	return icm42670_spi_update_register(&cfg->bus, reg, mask, data);
+#elif defined(ICM42670_BUS_DIRECT_I2C)
+	return icm42670_reg_update_i2c(&cfg->bus, reg, mask, data);
+#else
+	return cfg->bus_io->update(&cfg->bus, reg, mask, data);
+#endif
+}
+
+/* events posted to icm42670_data.init_event */
+#define ICM42670_INIT_READY	BIT(0)
+#define ICM42670_INIT_FAILED	BIT(1)
+
+/**
+ * @brief select the accel power mode for the current configuration
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_update_accel_power(const struct device *dev);
+
+/**
+ * @brief sleep for whatever is left of the start-up or settling time of the
+ *	  outputs @p chan needs
+ *
+ * @param dev icm42670 device pointer
+ * @param chan channel about to be read, SENSOR_CHAN_ALL for all outputs
+ */
+void icm42670_wait_startup(const struct device *dev, enum sensor_channel chan);
+
+/**
+ * @brief lock access to the icm42670 device driver
+ *
+ * @param dev icm42670 device pointer
+ */
+void icm42670_lock(const struct device *dev);
+
+/**
+ * @brief unlock access to the icm42670 device driver
+ *
+ * @param dev icm42670 device pointer
+ */
+void icm42670_unlock(const struct device *dev);
+
+#if defined(CONFIG_ICM42670_CONSUMERS) || defined(CONFIG_ICM42670_MOTION_POLICY)
+/**
+ * @brief change the accel and gyro rates, the caller must hold the driver lock
+ *
+ * Rates already in effect are left alone, without bus traffic.
+ *
+ * @param dev icm42670 device pointer
+ * @param accel_hz accel sampling rate
+ * @param gyro_hz gyro sampling rate
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_set_odr(const struct device *dev, uint16_t accel_hz, uint16_t gyro_hz);
+#endif
+
+/* true while the motion policy switches rate profiles */
+static inline bool icm42670_policy_running(const struct icm42670_data *data)
+{
+#ifdef CONFIG_ICM42670_MOTION_POLICY
+	return data->policy_running;
+#else
+	ARG_UNUSED(data);
+
+	return false;
+#endif
+}
+
+/* true while the registered consumers or the motion policy own the sampling rates */
+static inline bool icm42670_rate_owned(struct icm42670_data *data)
+{
+#ifdef CONFIG_ICM42670_CONSUMERS
+	if (!sys_slist_is_empty(&data->consumers)) {
+		return true;
+	}
+#endif
+
+	return icm42670_policy_running(data);
+}
+
+#if defined(CONFIG_ICM42670_TIMESTAMP) && defined(CONFIG_ICM42670_TRIGGER)
+/* host time of the last interrupt, 0 if none was recorded, @p clear consumes it */
+static inline uint64_t icm42670_irq_ns_get(struct icm42670_data *data, bool clear)
+{
+	k_spinlock_key_t key = k_spin_lock(&data->irq_lock);
+	uint64_t irq_ns = data->irq_ns;
+
+	if (clear) {
+		data->irq_ns = 0;
+	}
+
+	k_spin_unlock(&data->irq_lock, key);
+
+	return irq_ns;
+}
+#endif
+
+#ifdef CONFIG_ICM42670_SHELL
+/* true if dev is an icm42670 instance */
+bool icm42670_is_instance(const struct device *dev);
+#endif
+
+/* true once the sensor can be accessed, always the case without deferred init */
+static inline bool icm42670_is_ready(const struct device *dev)
+{
+#ifdef CONFIG_ICM42670_DEFERRED_INIT
+	struct icm42670_data *data = dev->data;
+
+	return k_event_test(&data->init_event, ICM42670_INIT_READY) != 0;
+#else
+	ARG_UNUSED(dev);
+
+	return true;
+#endif
+}
+
 #endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_H_ */
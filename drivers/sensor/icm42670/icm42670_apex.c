@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * APEX motion engine. The on-chip DMP runs the pedometer, tilt, significant
+ * motion and freefall detectors on the accel samples, so the host only
+ * wakes up for the events themselves. The detector tuning (APEX_CONFIG2 and
+ * up) is left at its reset values.
+ */
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include "icm42670.h"
+#include "icm42670_apex.h"
+#include "icm42670_cache.h"
+#include "icm42670_reg.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ICM42670, CONFIG_SENSOR_LOG_LEVEL);
+
+#define APEX_ENABLE_MASK (BIT_PED_ENABLE | BIT_TILT_ENABLE | BIT_SMD_ENABLE | BIT_FF_ENABLE)
+
+/* the DMP runs at one of a few fixed rates, which must not exceed the accel rate */
+static int icm42670_apex_odr(uint16_t accel_hz)
+{
+	if (accel_hz >= 100) {
+		return BIT_DMP_ODR_100;
+	} else if (accel_hz >= 50) {
+		return BIT_DMP_ODR_50;
+	} else if (accel_hz >= MIN_DMP_ODR) {
+		return BIT_DMP_ODR_25;
+	}
+
+	return -ENOTSUP;
+}
+
+static uint8_t icm42670_apex_enables(uint8_t features)
+{
+	uint8_t value = 0;
+
+	if (features & ICM42670_APEX_PEDOMETER) {
+		value |= BIT_PED_ENABLE;
+	}
+
+	if (features & ICM42670_APEX_TILT) {
+		value |= BIT_TILT_ENABLE;
+	}
+
+	if (features & ICM42670_APEX_SMD) {
+		value |= BIT_SMD_ENABLE;
+	}
+
+	if (features & ICM42670_APEX_FREEFALL) {
+		value |= BIT_FF_ENABLE;
+	}
+
+	return value;
+}
+
+static int icm42670_apex_wait_idle(const struct device *dev)
+{
+	const struct icm42670_config *cfg = dev->config;
+	uint8_t value;
+	int res;
+
+	for (int i = 0; i < DMP_POLL_ATTEMPTS; i++) {
+		k_msleep(DMP_POLL_INTERVAL_MS);
+
+		res = icm42670_bus_read(cfg, REG_APEX_DATA3, &value, 1);
+
+		if (res) {
+			return res;
+		}
+
+		if (value & BIT_DMP_IDLE) {
+			return 0;
+		}
+	}
+
+	LOG_ERR("DMP did not become idle");
+	return -ETIMEDOUT;
+}
+
+/* clear the APEX state in the DMP memory, done once before the first feature starts */
+static int icm42670_apex_reset(const struct device *dev)
+{
+	int res;
+
+	res = icm42670_reg_write(dev, REG_APEX_CONFIG0,
+				 FIELD_PREP(MASK_DMP_MEM_RESET, BIT_DMP_MEM_RESET_APEX_ST));
+
+	if (res) {
+		return res;
+	}
+
+	return icm42670_apex_wait_idle(dev);
+}
+
+/* let the DMP pick up the enabled features, it runs their init code and goes idle */
+static int icm42670_apex_init_dmp(const struct device *dev)
+{
+	int res;
+
+	res = icm42670_reg_write(dev, REG_APEX_CONFIG0, BIT_DMP_INIT_EN);
+
+	if (res) {
+		return res;
+	}
+
+	return icm42670_apex_wait_idle(dev);
+}
+
+int icm42670_apex_update(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	uint8_t features = data->apex_features;
+	uint8_t enables;
+	int odr = 0;
+	int res;
+
+#ifdef CONFIG_ICM42670_TRIGGER
+	for (int i = 0; i < ICM42670_APEX_EV_COUNT; i++) {
+		if (data->apex_handlers[i].handler) {
+			features |= BIT(i);
+		}
+	}
+#endif
+
+	/* significant motion is built on the step detector */
+	if (features & ICM42670_APEX_SMD) {
+		features |= ICM42670_APEX_PEDOMETER;
+	}
+
+	if (features) {
+		odr = icm42670_apex_odr(data->accel_hz);
+
+		if (odr < 0) {
+			LOG_ERR("Sampling frequency too low for APEX");
+			return odr;
+		}
+
+		if (!data->dmp_started) {
+			res = icm42670_apex_reset(dev);
+
+			if (res) {
+				return res;
+			}
+		}
+	}
+
+	enables = icm42670_apex_enables(features);
+	res = icm42670_reg_update(dev, REG_APEX_CONFIG1, (uint8_t)(APEX_ENABLE_MASK | MASK_DMP_ODR),
+				  enables | (uint8_t)odr);
+
+	if (res) {
+		return res;
+	}
+
+	if (features & ~data->apex_active) {
+		res = icm42670_apex_init_dmp(dev);
+
+		if (res) {
+			return res;
+		}
+
+		data->dmp_started = true;
+	}
+
+	data->apex_active = features;
+
+	/* the detectors do not need low noise, they run fine on a duty-cycled accel */
+	return icm42670_update_accel_power(dev);
+}
+
+#ifdef CONFIG_ICM42670_TRIGGER
+
+static int icm42670_apex_event(enum sensor_trigger_type type)
+{
+	if (type == (enum sensor_trigger_type)ICM42670_TRIG_STEP) {
+		return ICM42670_APEX_EV_STEP;
+	} else if (type == SENSOR_TRIG_TILT) {
+		return ICM42670_APEX_EV_TILT;
+	} else if (type == (enum sensor_trigger_type)ICM42670_TRIG_SIG_MOTION) {
+		return ICM42670_APEX_EV_SMD;
+	} else if (type == SENSOR_TRIG_FREEFALL) {
+		return ICM42670_APEX_EV_FREEFALL;
+	}
+
+	return -ENOTSUP;
+}
+
+int icm42670_apex_trigger_set(const struct device *dev, const struct sensor_trigger *trig,
+			      sensor_trigger_handler_t handler)
+{
+	struct icm42670_data *data = dev->data;
+	int ev = icm42670_apex_event(trig->type);
+	struct icm42670_apex_handler prev;
+	int res;
+
+	if (ev < 0) {
+		return ev;
+	}
+
+	prev = data->apex_handlers[ev];
+	data->apex_handlers[ev].handler = handler;
+	data->apex_handlers[ev].trigger = trig;
+
+	res = icm42670_apex_update(dev);
+
+	if (res) {
+		data->apex_handlers[ev] = prev;
+	}
+
+	return res;
+}
+
+uint8_t icm42670_apex_int_sources(const struct icm42670_data *data)
+{
+	uint8_t value = 0;
+
+	if (data->apex_handlers[ICM42670_APEX_EV_STEP].handler) {
+		value |= BIT_INT_STEP_DET_INT1_EN;
+	}
+
+	if (data->apex_handlers[ICM42670_APEX_EV_TILT].handler) {
+		value |= BIT_INT_TILT_DET_INT1_EN;
+	}
+
+	if (data->apex_handlers[ICM42670_APEX_EV_FREEFALL].handler) {
+		value |= BIT_INT_FF_INT1_EN;
+	}
+
+	return value;
+}
+
+void icm42670_apex_events(const struct device *dev, uint8_t status2,
+			  struct icm42670_apex_handler *fired)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	uint8_t status3 = 0;
+
+	memset(fired, 0, sizeof(data->apex_handlers));
+
+	if (icm42670_apex_int_sources(data)) {
+		if (icm42670_bus_read(cfg, REG_INT_STATUS3, &status3, 1)) {
+			status3 = 0;
+		}
+	}
+
+	if (status3 & BIT_INT_STATUS_STEP_DET) {
+		fired[ICM42670_APEX_EV_STEP] = data->apex_handlers[ICM42670_APEX_EV_STEP];
+	}
+
+	if (status3 & BIT_INT_STATUS_TILT_DET) {
+		fired[ICM42670_APEX_EV_TILT] = data->apex_handlers[ICM42670_APEX_EV_TILT];
+	}
+
+	if (status2 & BIT_INT_STATUS_SMD) {
+		fired[ICM42670_APEX_EV_SMD] = data->apex_handlers[ICM42670_APEX_EV_SMD];
+	}
+
+	if (status3 & BIT_INT_STATUS_FF_DET) {
+		fired[ICM42670_APEX_EV_FREEFALL] = data->apex_handlers[ICM42670_APEX_EV_FREEFALL];
+	}
+}
+
+#endif /* CONFIG_ICM42670_TRIGGER */
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_APEX_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_APEX_H_
+
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include "icm42670.h"
+
+#ifdef CONFIG_ICM42670_APEX
+
+/**
+ * @brief apply the APEX features requested by attribute and by triggers
+ *
+ * Starts the DMP on first use, follows the accel sampling rate with the DMP
+ * rate and reselects the accel power mode. The caller must hold the driver
+ * lock.
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, -ENOTSUP if the accel samples too slowly for the
+ *	   DMP, negative error code otherwise
+ */
+int icm42670_apex_update(const struct device *dev);
+
+#ifdef CONFIG_ICM42670_TRIGGER
+/**
+ * @brief install or remove the handler of an APEX trigger
+ *
+ * @param dev icm42670 device pointer
+ * @param trig step, tilt, significant motion or freefall trigger
+ * @param handler handler, NULL to remove it
+ * @return int 0 on success, -ENOTSUP for other trigger types
+ */
+int icm42670_apex_trigger_set(const struct device *dev, const struct sensor_trigger *trig,
+			      sensor_trigger_handler_t handler);
+
+/**
+ * @brief INT_SOURCE6 bits routing the installed APEX triggers to INT1
+ *
+ * @param data icm42670 driver data
+ * @return uint8_t INT_SOURCE6 value
+ */
+uint8_t icm42670_apex_int_sources(const struct icm42670_data *data);
+
+/**
+ * @brief collect the handlers of the APEX events that fired
+ *
+ * Reads INT_STATUS3 when an event reported there has a handler, reading it
+ * clears the flags. The caller must hold the driver lock.
+ *
+ * @param dev icm42670 device pointer
+ * @param status2 INT_STATUS2 value, for the significant motion flag
+ * @param fired destination, handlers of events that did not fire are NULL
+ */
+void icm42670_apex_events(const struct device *dev, uint8_t status2,
+			  struct icm42670_apex_handler *fired);
+#endif /* CONFIG_ICM42670_TRIGGER */
+
+#endif /* CONFIG_ICM42670_APEX */
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_APEX_H_ */
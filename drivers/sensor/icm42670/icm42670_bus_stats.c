@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Instrumented bus access. Wraps the SPI or I2C bus_io of an instance and
+ * accounts every transaction to its register class, to measure how much
+ * of a shared bus the sensor takes. Failed transactions are retried up to
+ * CONFIG_ICM42670_BUS_RETRIES times.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include "icm42670.h"
+#include "icm42670_reg.h"
+
+#define BUS_HIST_FIRST_US 16
+
+static const struct icm42670_config *icm42670_bus_config(const union icm42670_bus *bus)
+{
+	/* bus_io is only ever called with the bus member of the instance config */
+	return CONTAINER_OF(bus, struct icm42670_config, bus);
+}
+
+static enum icm42670_bus_class icm42670_bus_class(uint16_t reg)
+{
+	if (FIELD_GET(REG_BANK_MASK, reg)) {
+		return ICM42670_BUS_CLASS_MREG;
+	}
+
+	if (((reg >= REG_TEMP_DATA1) && (reg <= REG_TMST_FSYNCL)) ||
+	    ((reg >= REG_APEX_DATA4) && (reg <= REG_APEX_DATA5)) ||
+	    ((reg >= REG_APEX_DATA0) && (reg <= REG_APEX_DATA3)) ||
+	    ((reg >= REG_INT_STATUS_DRDY) && (reg <= REG_FIFO_DATA))) {
+		return ICM42670_BUS_CLASS_DATA;
+	}
+
+	return ICM42670_BUS_CLASS_CONFIG;
+}
+
+static int icm42670_bus_hist_bin(uint32_t us)
+{
+	if (us < BUS_HIST_FIRST_US) {
+		return 0;
+	}
+
+	return MIN(LOG2(us) - LOG2(BUS_HIST_FIRST_US) + 1, ICM42670_BUS_HIST_BINS - 1);
+}
+
+static void icm42670_bus_record(const struct icm42670_config *cfg, uint16_t reg, size_t len,
+				int res, int retries, uint32_t start)
+{
+	struct icm42670_bus_monitor *mon = cfg->bus_monitor;
+	struct icm42670_bus_class_stats *cls = &mon->stats.classes[icm42670_bus_class(reg)];
+	uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+	K_SPINLOCK(&mon->lock) {
+		cls->transactions++;
+		cls->bytes += len;
+		cls->retries += retries;
+		cls->busy_us += us;
+
+		if (res) {
+			cls->errors++;
+		}
+
+		mon->stats.latency_hist[icm42670_bus_hist_bin(us)]++;
+		mon->stats.max_latency_us = MAX(mon->stats.max_latency_us, us);
+	}
+}
+
+static int icm42670_bus_check_stats(const union icm42670_bus *bus)
+{
+	return icm42670_bus_config(bus)->bus_io_raw->check(bus);
+}
+
+static int icm42670_reg_read_stats(const union icm42670_bus *bus, uint16_t reg, uint8_t *data,
+				   size_t len)
+{
+	const struct icm42670_config *cfg = icm42670_bus_config(bus);
+	uint32_t start = k_cycle_get_32();
+	int retries;
+	int res = cfg->bus_io_raw->read(bus, reg, data, len);
+
+	for (retries = 0; res && (retries < CONFIG_ICM42670_BUS_RETRIES); retries++) {
+		res = cfg->bus_io_raw->read(bus, reg, data, len);
+	}
+
+	icm42670_bus_record(cfg, reg, len, res, retries, start);
+
+	return res;
+}
+
+static int icm42670_reg_write_block_stats(const union icm42670_bus *bus, uint16_t reg,
+					  const uint8_t *data, size_t len)
+{
+	const struct icm42670_config *cfg = icm42670_bus_config(bus);
+	uint32_t start = k_cycle_get_32();
+	int retries;
+	int res = cfg->bus_io_raw->write_block(bus, reg, data, len);
+
+	for (retries = 0; res && (retries < CONFIG_ICM42670_BUS_RETRIES); retries++) {
+		res = cfg->bus_io_raw->write_block(bus, reg, data, len);
+	}
+
+	icm42670_bus_record(cfg, reg, len, res, retries, start);
+
+	return res;
+}
+
+static int icm42670_reg_write_stats(const union icm42670_bus *bus, uint16_t reg, uint8_t data)
+{
+	const struct icm42670_config *cfg = icm42670_bus_config(bus);
+	uint32_t start = k_cycle_get_32();
+	int retries;
+	int res = cfg->bus_io_raw->write(bus, reg, data);
+
+	for (retries = 0; res && (retries < CONFIG_ICM42670_BUS_RETRIES); retries++) {
+		res = cfg->bus_io_raw->write(bus, reg, data);
+	}
+
+	icm42670_bus_record(cfg, reg, 1, res, retries, start);
+
+	return res;
+}
+
+/* a read-modify-write, accounted as one transaction of one byte each way */
+static int icm42670_reg_update_stats(const union icm42670_bus *bus, uint16_t reg, uint8_t mask,
+				     uint8_t val)
+{
+	const struct icm42670_config *cfg = icm42670_bus_config(bus);
+	uint32_t start = k_cycle_get_32();
+	int retries;
+	int res = cfg->bus_io_raw->update(bus, reg, mask, val);
+
+	for (retries = 0; res && (retries < CONFIG_ICM42670_BUS_RETRIES); retries++) {
+		res = cfg->bus_io_raw->update(bus, reg, mask, val);
+	}
+
+	icm42670_bus_record(cfg, reg, 2, res, retries, start);
+
+	return res;
+}
+
+const struct icm42670_bus_io icm42670_bus_io_stats = {
+	.check = icm42670_bus_check_stats,
+	.read = icm42670_reg_read_stats,
+	.write = icm42670_reg_write_stats,
+	.write_block = icm42670_reg_write_block_stats,
+	.update = icm42670_reg_update_stats,
+};
+
+void icm42670_bus_stats_get(const struct device *dev, struct icm42670_bus_stats *stats)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_bus_monitor *mon = cfg->bus_monitor;
+
+	K_SPINLOCK(&mon->lock) {
+		*stats = mon->stats;
+	}
+}
+
+void icm42670_bus_stats_reset(const struct device *dev)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_bus_monitor *mon = cfg->bus_monitor;
+
+	K_SPINLOCK(&mon->lock) {
+		memset(&mon->stats, 0, sizeof(mon->stats));
+	}
+}
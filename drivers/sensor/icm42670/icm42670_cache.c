@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Shadow cache of the writable configuration registers. The driver is the
+ * only writer of these registers, so once a value is known, updates become
+ * a single write and reads never touch the bus.
+ */
+
+#include <zephyr/sys/util.h>
+#include "icm42670.h"
+#include "icm42670_cache.h"
+#include "icm42670_reg.h"
+
+/*
+ * Cached registers, sorted by address. Registers with self-clearing or
+ * hardware-updated bits (SIGNAL_PATH_RESET, APEX_CONFIG0, status and data
+ * registers) must not be listed here.
+ */
+static const uint16_t icm42670_cached_regs[] = {
+	REG_DEVICE_CONFIG,
+	REG_DRIVE_CONFIG1,
+	REG_DRIVE_CONFIG2,
+	REG_DRIVE_CONFIG3,
+	REG_INT_CONFIG,
+	REG_PWR_MGMT0,
+	REG_GYRO_CONFIG0,
+	REG_ACCEL_CONFIG0,
+	REG_TEMP_CONFIG0,
+	REG_GYRO_CONFIG1,
+	REG_ACCEL_CONFIG1,
+	REG_APEX_CONFIG1,
+	REG_WOM_CONFIG,
+	REG_FIFO_CONFIG1,
+	REG_FIFO_CONFIG2,
+	REG_FIFO_CONFIG3,
+	REG_INT_SOURCE0,
+	REG_INT_SOURCE1,
+	REG_INT_SOURCE3,
+	REG_INT_SOURCE4,
+	REG_INTF_CONFIG0,
+	REG_INTF_CONFIG1,
+	REG_TMST_CONFIG1,
+	REG_FIFO_CONFIG5,
+	REG_FIFO_CONFIG6,
+	REG_FSYNC_CONFIG,
+	REG_INT_CONFIG0,
+	REG_INT_CONFIG1,
+	REG_SENSOR_CONFIG3,
+	REG_INT_SOURCE6,
+	REG_INT_SOURCE7,
+	REG_INT_SOURCE8,
+	REG_INT_SOURCE9,
+	REG_INT_SOURCE10,
+	REG_APEX_CONFIG2,
+	REG_APEX_CONFIG3,
+	REG_APEX_CONFIG4,
+	REG_APEX_CONFIG5,
+	REG_APEX_CONFIG9,
+	REG_APEX_CONFIG10,
+	REG_APEX_CONFIG11,
+	REG_ACCEL_WOM_X_THR,
+	REG_ACCEL_WOM_Y_THR,
+	REG_ACCEL_WOM_Z_THR,
+	REG_OFFSET_USER0,
+	REG_OFFSET_USER1,
+	REG_OFFSET_USER2,
+	REG_OFFSET_USER3,
+	REG_OFFSET_USER4,
+	REG_OFFSET_USER5,
+	REG_OFFSET_USER6,
+	REG_OFFSET_USER7,
+	REG_OFFSET_USER8,
+	REG_APEX_CONFIG12,
+};
+
+BUILD_ASSERT(ARRAY_SIZE(icm42670_cached_regs) == ICM42670_REG_CACHE_SIZE,
+	     "ICM42670_REG_CACHE_SIZE does not match the cached register table");
+BUILD_ASSERT(ICM42670_REG_CACHE_SIZE <= 64, "valid bitmap is 64 bits wide");
+
+/* first and last register of the bank 0 configuration block read by the sync */
+#define SYNC_FIRST_REG			REG_PWR_MGMT0
+#define SYNC_LAST_REG			REG_INT_SOURCE4
+#define SYNC_SIZE			(SYNC_LAST_REG - SYNC_FIRST_REG + 1)
+
+static int icm42670_cache_index(uint16_t reg)
+{
+	int lo = 0;
+	int hi = ARRAY_SIZE(icm42670_cached_regs) - 1;
+
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+
+		if (icm42670_cached_regs[mid] == reg) {
+			return mid;
+		} else if (icm42670_cached_regs[mid] < reg) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	return -ENOENT;
+}
+
+static void icm42670_cache_store(struct icm42670_data *data, int idx, uint8_t val)
+{
+	data->reg_cache[idx] = val;
+	data->reg_cache_valid |= BIT64(idx);
+}
+
+int icm42670_reg_read(const struct device *dev, uint16_t reg, uint8_t *val)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	int idx = icm42670_cache_index(reg);
+	int res;
+
+	if ((idx >= 0) && (data->reg_cache_valid & BIT64(idx))) {
+		*val = data->reg_cache[idx];
+		return 0;
+	}
+
+	res = icm42670_bus_read(cfg, reg, val, 1);
+
+	if (res) {
+		return res;
+	}
+
+	if (idx >= 0) {
+		icm42670_cache_store(data, idx, *val);
+	}
+
+	return 0;
+}
+
+int icm42670_reg_write(const struct device *dev, uint16_t reg, uint8_t val)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	int idx = icm42670_cache_index(reg);
+	int res;
+
+	if ((idx >= 0) && (data->reg_cache_valid & BIT64(idx)) && (data->reg_cache[idx] == val)) {
+		return 0;
+	}
+
+	res = icm42670_bus_write(cfg, reg, val);
+
+	if (idx < 0) {
+		return res;
+	}
+
+	if (res) {
+		/* the register content is unknown after a failed write */
+		data->reg_cache_valid &= ~BIT64(idx);
+		return res;
+	}
+
+	icm42670_cache_store(data, idx, val);
+
+	return 0;
+}
+
+int icm42670_reg_update(const struct device *dev, uint16_t reg, uint8_t mask, uint8_t val)
+{
+	uint8_t temp = 0;
+	int res = icm42670_reg_read(dev, reg, &temp);
+
+	if (res) {
+		return res;
+	}
+
+	temp &= ~mask;
+	temp |= FIELD_PREP(mask, val);
+
+	return icm42670_reg_write(dev, reg, temp);
+}
+
+int icm42670_reg_read_block(const struct device *dev, uint16_t reg, uint8_t *buf, size_t len)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	bool cached = true;
+	int res;
+
+	for (size_t i = 0; i < len; i++) {
+		int idx = icm42670_cache_index(reg + i);
+
+		if ((idx < 0) || !(data->reg_cache_valid & BIT64(idx))) {
+			cached = false;
+			break;
+		}
+
+		buf[i] = data->reg_cache[idx];
+	}
+
+	if (cached) {
+		return 0;
+	}
+
+	res = icm42670_bus_read(cfg, reg, buf, len);
+
+	if (res) {
+		return res;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		int idx = icm42670_cache_index(reg + i);
+
+		if (idx >= 0) {
+			icm42670_cache_store(data, idx, buf[i]);
+		}
+	}
+
+	return 0;
+}
+
+int icm42670_reg_write_block(const struct device *dev, uint16_t reg, const uint8_t *buf,
+			     size_t len)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	int res = icm42670_bus_write_block(cfg, reg, buf, len);
+
+	for (size_t i = 0; i < len; i++) {
+		int idx = icm42670_cache_index(reg + i);
+
+		if (idx < 0) {
+			continue;
+		}
+
+		if (res) {
+			/* a failed block write leaves every register of the block unknown */
+			data->reg_cache_valid &= ~BIT64(idx);
+		} else {
+			icm42670_cache_store(data, idx, buf[i]);
+		}
+	}
+
+	return res;
+}
+
+void icm42670_reg_cache_invalidate(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+
+	data->reg_cache_valid = 0;
+}
+
+int icm42670_reg_cache_sync(const struct device *dev)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	uint8_t buffer[SYNC_SIZE];
+	int res = icm42670_bus_read(cfg, SYNC_FIRST_REG, buffer, SYNC_SIZE);
+
+	if (res) {
+		return res;
+	}
+
+	for (int i = 0; i < SYNC_SIZE; i++) {
+		int idx = icm42670_cache_index(SYNC_FIRST_REG + i);
+
+		if (idx >= 0) {
+			icm42670_cache_store(data, idx, buffer[i]);
+		}
+	}
+
+	return 0;
+}
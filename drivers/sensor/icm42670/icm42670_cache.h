@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_CACHE_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+/**
+ * @brief read a register, served from the shadow cache when possible
+ *
+ * @param dev icm42670 device pointer
+ * @param reg register address, including the bank bits
+ * @param val destination for the register value
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_reg_read(const struct device *dev, uint16_t reg, uint8_t *val);
+
+/**
+ * @brief write a register and keep the shadow cache in sync
+ *
+ * Writes of an unchanged value to a cached register are skipped.
+ *
+ * @param dev icm42670 device pointer
+ * @param reg register address, including the bank bits
+ * @param val value to write
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_reg_write(const struct device *dev, uint16_t reg, uint8_t val);
+
+/**
+ * @brief update a register field, a single bus write for cached registers
+ *
+ * @param dev icm42670 device pointer
+ * @param reg register address, including the bank bits
+ * @param mask field mask
+ * @param val field value, shifted into place with FIELD_PREP
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_reg_update(const struct device *dev, uint16_t reg, uint8_t mask, uint8_t val);
+
+/**
+ * @brief read a block of consecutive registers
+ *
+ * The block is served from the cache when all of its registers are cached,
+ * otherwise it is read from the bus and the cached registers are refreshed.
+ *
+ * @param dev icm42670 device pointer
+ * @param reg first register address, including the bank bits
+ * @param buf destination buffer
+ * @param len number of registers
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_reg_read_block(const struct device *dev, uint16_t reg, uint8_t *buf, size_t len);
+
+/**
+ * @brief write a block of consecutive registers, batching MREG accesses
+ *
+ * @param dev icm42670 device pointer
+ * @param reg first register address, including the bank bits
+ * @param buf values to write
+ * @param len number of registers
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_reg_write_block(const struct device *dev, uint16_t reg, const uint8_t *buf,
+			     size_t len);
+
+/**
+ * @brief forget all cached values, e.g. after a soft reset
+ *
+ * @param dev icm42670 device pointer
+ */
+void icm42670_reg_cache_invalidate(const struct device *dev);
+
+/**
+ * @brief fill the cache for the bank 0 configuration block in a single burst
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_reg_cache_sync(const struct device *dev);
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_CACHE_H_ */
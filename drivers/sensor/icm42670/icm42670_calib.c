@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Offset calibration. The bias measured while the device lies still is
+ * written to the OFFSET_USER registers, the sensor then subtracts it from
+ * every sample itself. The register values are stored with the settings
+ * subsystem so the calibration survives a reboot.
+ */
+
+#include <stdlib.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include "icm42670.h"
+#include "icm42670_cache.h"
+#include "icm42670_calib.h"
+#include "icm42670_reg.h"
+#include "icm42670_trigger.h"
+
+#ifdef CONFIG_ICM42670_CALIBRATION_SETTINGS
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/printk.h>
+#endif
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ICM42670, CONFIG_SENSOR_LOG_LEVEL);
+
+#define CALIB_SETTINGS_ROOT "icm42670"
+#define CALIB_KEY_SIZE 32
+
+/*
+ * OFFSET_USER0..8 hold six 12-bit two's complement values, the high nibbles
+ * of two neighbouring offsets share a register, see datasheet section 15.
+ */
+static void icm42670_calib_pack(const int16_t *gyro, const int16_t *accel, uint8_t *buf)
+{
+	buf[0] = gyro[0] & 0xff;
+	buf[1] = ((gyro[1] >> 4) & 0xf0) | ((gyro[0] >> 8) & 0x0f);
+	buf[2] = gyro[1] & 0xff;
+	buf[3] = gyro[2] & 0xff;
+	buf[4] = ((accel[0] >> 4) & 0xf0) | ((gyro[2] >> 8) & 0x0f);
+	buf[5] = accel[0] & 0xff;
+	buf[6] = accel[1] & 0xff;
+	buf[7] = ((accel[2] >> 4) & 0xf0) | ((accel[1] >> 8) & 0x0f);
+	buf[8] = accel[2] & 0xff;
+}
+
+/* mean of the summed samples in offset register units, negated to cancel the bias */
+static int16_t icm42670_calib_offset(int64_t sum, int64_t divisor, int32_t per_unit)
+{
+	int64_t offset = DIV_ROUND_CLOSEST(-sum * per_unit, divisor);
+
+	return CLAMP(offset, -OFFSET_USER_MAX, OFFSET_USER_MAX);
+}
+
+#ifdef CONFIG_ICM42670_CALIBRATION_SETTINGS
+
+/* one settings entry per instance, named after the device */
+static void icm42670_calib_key(const struct device *dev, char *key)
+{
+	snprintk(key, CALIB_KEY_SIZE, CALIB_SETTINGS_ROOT "/%s", dev->name);
+}
+
+struct icm42670_calib_load {
+	uint8_t *buf;
+	bool found;
+};
+
+static int icm42670_calib_load_cb(const char *key, size_t len, settings_read_cb read_cb,
+				  void *cb_arg, void *param)
+{
+	struct icm42670_calib_load *load = param;
+
+	ARG_UNUSED(key);
+
+	if (len != OFFSET_USER_SIZE) {
+		LOG_WRN("ignoring stored offsets of unexpected size %u", (unsigned int)len);
+		return 0;
+	}
+
+	if (read_cb(cb_arg, load->buf, len) == len) {
+		load->found = true;
+	}
+
+	return 0;
+}
+
+#endif /* CONFIG_ICM42670_CALIBRATION_SETTINGS */
+
+static int icm42670_calib_store(const struct device *dev, const uint8_t *buf)
+{
+#ifdef CONFIG_ICM42670_CALIBRATION_SETTINGS
+	char key[CALIB_KEY_SIZE];
+	bool clear = true;
+
+	for (int i = 0; i < OFFSET_USER_SIZE; i++) {
+		clear &= (buf[i] == 0);
+	}
+
+	icm42670_calib_key(dev, key);
+
+	/* zero offsets are the reset state, no need to keep an entry for them */
+	return clear ? settings_delete(key) : settings_save_one(key, buf, OFFSET_USER_SIZE);
+#else
+	ARG_UNUSED(dev);
+	ARG_UNUSED(buf);
+
+	return 0;
+#endif
+}
+
+int icm42670_calib_restore(const struct device *dev)
+{
+#ifdef CONFIG_ICM42670_CALIBRATION_SETTINGS
+	uint8_t buf[OFFSET_USER_SIZE];
+	struct icm42670_calib_load load = { .buf = buf };
+	char key[CALIB_KEY_SIZE];
+	int res;
+
+	res = settings_subsys_init();
+
+	if (res) {
+		LOG_ERR("settings init failed (%d)", res);
+		return res;
+	}
+
+	icm42670_calib_key(dev, key);
+	res = settings_load_subtree_direct(key, icm42670_calib_load_cb, &load);
+
+	if (res || !load.found) {
+		return res;
+	}
+
+	LOG_DBG("%s restoring stored offsets", dev->name);
+
+	return icm42670_reg_write_block(dev, REG_OFFSET_USER0, buf, sizeof(buf));
+#else
+	ARG_UNUSED(dev);
+
+	return 0;
+#endif
+}
+
+/* drain the FIFO until the sums cover the requested number of samples */
+static int icm42670_calib_collect(const struct device *dev, uint16_t samples, int64_t *accel,
+				  int64_t *gyro)
+{
+	struct icm42670_data *data = dev->data;
+	struct icm42670_fifo_frame frames[CALIB_BATCH_SIZE];
+	uint16_t odr = MAX(MIN(data->accel_hz, data->gyro_hz), 1);
+	uint32_t period_ms = MAX(MSEC_PER_SEC / odr, 1);
+	int64_t deadline = k_uptime_get() + 2 * (int64_t)samples * period_ms +
+			   CALIB_TIMEOUT_MARGIN_MS;
+	uint16_t count = 0;
+
+	while (count < samples) {
+		int n = icm42670_fifo_read(dev, frames, MIN(samples - count, CALIB_BATCH_SIZE));
+
+		if (n < 0) {
+			return n;
+		}
+
+		for (int i = 0; i < n; i++) {
+			for (int axis = 0; axis < 3; axis++) {
+				accel[axis] += frames[i].accel[axis];
+				gyro[axis] += frames[i].gyro[axis];
+			}
+		}
+
+		count += n;
+
+		if ((n == 0) && (k_uptime_get() > deadline)) {
+			LOG_ERR("calibration timed out after %u samples", count);
+			return -ETIMEDOUT;
+		} else if (n == 0) {
+			k_msleep(period_ms);
+		}
+	}
+
+	return 0;
+}
+
+int icm42670_calibrate(const struct device *dev, uint16_t samples)
+{
+	struct icm42670_data *data = dev->data;
+	uint8_t buf[OFFSET_USER_SIZE] = { 0 };
+	uint8_t prev[OFFSET_USER_SIZE];
+	int64_t accel_sum[3] = { 0 };
+	int64_t gyro_sum[3] = { 0 };
+	int16_t accel[3];
+	int16_t gyro[3];
+	int64_t one_g;
+	int down = 0;
+	int res;
+	/* high resolution frames are at +-16g and +-2000dps whatever the full scale */
+	uint8_t accel_fs_sel = IS_ENABLED(CONFIG_ICM42670_FIFO_HIRES) ? 0 : data->accel_fs_sel;
+	uint8_t gyro_fs_sel = IS_ENABLED(CONFIG_ICM42670_FIFO_HIRES) ? 0 : data->gyro_fs_sel;
+
+	if (samples == 0) {
+		return -EINVAL;
+	}
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	/* someone else owns the FIFO, restarting it would drop their samples */
+	if (data->fifo_enabled) {
+		icm42670_unlock(dev);
+		return -EBUSY;
+	}
+
+	/* kept to put back if the measurement fails */
+	res = icm42670_reg_read_block(dev, REG_OFFSET_USER0, prev, sizeof(prev));
+
+	if (res) {
+		icm42670_unlock(dev);
+		return res;
+	}
+
+	/* measure the bias without the previous correction */
+	res = icm42670_reg_write_block(dev, REG_OFFSET_USER0, buf, sizeof(buf));
+
+	if (!res) {
+		res = icm42670_fifo_start(dev);
+	}
+
+	icm42670_unlock(dev);
+
+	if (!res) {
+		res = icm42670_calib_collect(dev, samples, accel_sum, gyro_sum);
+		icm42670_fifo_stop(dev);
+	}
+
+	if (res) {
+		goto restore;
+	}
+
+	/* the axis that sees most of gravity points up or down, gravity is not a bias */
+	for (int axis = 1; axis < 3; axis++) {
+		if (llabs(accel_sum[axis]) > llabs(accel_sum[down])) {
+			down = axis;
+		}
+	}
+
+	/* sum of 1g over all samples, the sensitivity doubles with every FS_SEL step */
+	one_g = (int64_t)samples << (MIN_ACCEL_SENS_SHIFT + accel_fs_sel);
+	accel_sum[down] -= (accel_sum[down] < 0) ? -one_g : one_g;
+
+	for (int axis = 0; axis < 3; axis++) {
+		accel[axis] = icm42670_calib_offset(accel_sum[axis], one_g, OFFSET_ACCEL_PER_G);
+		gyro[axis] = icm42670_calib_offset(
+			gyro_sum[axis], (int64_t)samples * (MIN_GYRO_SENS_X10 << gyro_fs_sel),
+			OFFSET_GYRO_PER_DPS * 10);
+	}
+
+	icm42670_calib_pack(gyro, accel, buf);
+
+	LOG_DBG("%s accel offsets %d %d %d, gyro offsets %d %d %d", dev->name, accel[0], accel[1],
+		accel[2], gyro[0], gyro[1], gyro[2]);
+
+	icm42670_lock(dev);
+	res = icm42670_reg_write_block(dev, REG_OFFSET_USER0, buf, sizeof(buf));
+	icm42670_unlock(dev);
+
+	if (res) {
+		goto restore;
+	}
+
+	return icm42670_calib_store(dev, buf);
+
+restore:
+	/* the stored settings still hold the previous offsets, so must the device */
+	icm42670_lock(dev);
+	(void)icm42670_reg_write_block(dev, REG_OFFSET_USER0, prev, sizeof(prev));
+	icm42670_unlock(dev);
+
+	return res;
+}
+
+int icm42670_calibration_clear(const struct device *dev)
+{
+	uint8_t buf[OFFSET_USER_SIZE] = { 0 };
+	int res;
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+	res = icm42670_reg_write_block(dev, REG_OFFSET_USER0, buf, sizeof(buf));
+	icm42670_unlock(dev);
+
+	if (res) {
+		return res;
+	}
+
+	return icm42670_calib_store(dev, buf);
+}
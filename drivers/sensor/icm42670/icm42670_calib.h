@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_CALIB_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_CALIB_H_
+
+#include <zephyr/device.h>
+
+/**
+ * @brief write the stored offsets back to the OFFSET_USER registers
+ *
+ * Called once the sensor is configured during init. Without stored offsets
+ * or without CONFIG_ICM42670_CALIBRATION_SETTINGS this does nothing.
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_calib_restore(const struct device *dev);
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_CALIB_H_ */
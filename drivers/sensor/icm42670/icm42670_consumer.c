@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Several consumers at their own rates. The sensor runs at the rate of the
+ * fastest one, every FIFO watermark drain is decoded once and each consumer
+ * averages the frames down to its rate, so the bus traffic does not depend
+ * on the number of consumers.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/slist.h>
+#include <zephyr/sys/util.h>
+#include "icm42670.h"
+#include "icm42670_consumer.h"
+#include "icm42670_fifo.h"
+#include "icm42670_trigger.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ICM42670, CONFIG_SENSOR_LOG_LEVEL);
+
+#define CONSUMER_MAX_HZ 1600
+/* the slowest gyro rate, both outputs go to the FIFO at the same rate */
+#define CONSUMER_MIN_HZ 12
+
+/* the supported rate at or above @p hz, 1600 Hz halved down to 12 Hz */
+static uint16_t icm42670_consumer_odr(uint16_t hz)
+{
+	uint16_t odr = CONSUMER_MAX_HZ;
+
+	hz = MAX(hz, CONSUMER_MIN_HZ);
+
+	while ((odr / 2) >= hz) {
+		odr /= 2;
+	}
+
+	return odr;
+}
+
+/* run the sensor at the rate of the fastest consumer, the caller holds the lock */
+static int icm42670_consumer_update(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	struct icm42670_consumer *consumer;
+	uint16_t hz = 0;
+	uint16_t odr;
+	int res;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&data->consumers, consumer, node) {
+		hz = MAX(hz, consumer->hz);
+	}
+
+	/* the last consumer is gone, leave the rate as it is */
+	if (hz == 0) {
+		return 0;
+	}
+
+	odr = icm42670_consumer_odr(hz);
+	res = icm42670_set_odr(dev, odr, odr);
+
+	if (res) {
+		return res;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&data->consumers, consumer, node) {
+		consumer->decimation = MAX(DIV_ROUND_CLOSEST(odr, consumer->hz), 1);
+	}
+
+	return 0;
+}
+
+/* add one frame to the running mean, emit the mean every decimation frames */
+static void icm42670_consumer_feed(const struct device *dev, struct icm42670_consumer *consumer,
+				   const struct icm42670_fifo_frame *frame)
+{
+	struct icm42670_fifo_frame *out;
+
+	/* samples of two configurations may be at two full scales, never mix them */
+	if ((consumer->count > 0) && (consumer->config_gen != frame->config_gen)) {
+		consumer->count = 0;
+	}
+
+	if (consumer->count == 0) {
+		memset(consumer->sum, 0, sizeof(consumer->sum));
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+		memset(consumer->sum_hires, 0, sizeof(consumer->sum_hires));
+#endif
+		consumer->config_gen = frame->config_gen;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		consumer->sum[i] += frame->accel[i];
+		consumer->sum[3 + i] += frame->gyro[i];
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+		consumer->sum_hires[i] += frame->accel_hires[i];
+		consumer->sum_hires[3 + i] += frame->gyro_hires[i];
+#endif
+	}
+
+	consumer->sum[6] += frame->temp;
+
+	if (++consumer->count < consumer->decimation) {
+		return;
+	}
+
+	/* timestamps, header and scale of the newest frame averaged */
+	out = &consumer->frames[consumer->pending++];
+	*out = *frame;
+
+	for (int i = 0; i < 3; i++) {
+		out->accel[i] = DIV_ROUND_CLOSEST(consumer->sum[i], consumer->count);
+		out->gyro[i] = DIV_ROUND_CLOSEST(consumer->sum[3 + i], consumer->count);
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+		out->accel_hires[i] = DIV_ROUND_CLOSEST(consumer->sum_hires[i], consumer->count);
+		out->gyro_hires[i] = DIV_ROUND_CLOSEST(consumer->sum_hires[3 + i], consumer->count);
+#endif
+	}
+
+	out->temp = DIV_ROUND_CLOSEST(consumer->sum[6], consumer->count);
+	consumer->count = 0;
+
+	if (consumer->pending == consumer->max_frames) {
+		consumer->pending = 0;
+		consumer->handler(dev, consumer, consumer->frames, consumer->max_frames);
+	}
+}
+
+void icm42670_consumer_drain(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	struct icm42670_consumer *consumer;
+	int n;
+
+	icm42670_lock(dev);
+
+	/* decode each batch once, every consumer decimates the same frames */
+	do {
+		n = icm42670_fifo_read(dev, data->consumer_frames, ARRAY_SIZE(data->consumer_frames));
+
+		for (int i = 0; i < n; i++) {
+			SYS_SLIST_FOR_EACH_CONTAINER(&data->consumers, consumer, node) {
+				icm42670_consumer_feed(dev, consumer, &data->consumer_frames[i]);
+			}
+		}
+	} while (n == ARRAY_SIZE(data->consumer_frames));
+
+	if (n < 0) {
+		LOG_ERR("FIFO drain failed (%d)", n);
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&data->consumers, consumer, node) {
+		size_t pending = consumer->pending;
+
+		if (pending > 0) {
+			consumer->pending = 0;
+			consumer->handler(dev, consumer, consumer->frames, pending);
+		}
+	}
+
+	icm42670_unlock(dev);
+}
+
+int icm42670_consumer_add(const struct device *dev, struct icm42670_consumer *consumer)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	if (!consumer->handler || !consumer->frames || (consumer->max_frames == 0) ||
+	    (consumer->hz == 0) || (consumer->hz > CONSUMER_MAX_HZ)) {
+		return -EINVAL;
+	}
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	if (sys_slist_find(&data->consumers, &consumer->node, NULL)) {
+		res = -EALREADY;
+		goto cleanup;
+	}
+
+	consumer->count = 0;
+	consumer->pending = 0;
+	sys_slist_append(&data->consumers, &consumer->node);
+
+	res = icm42670_consumer_update(dev);
+
+	if (!res) {
+		res = icm42670_fifo_claim(dev, ICM42670_FIFO_OWNER_CONSUMERS);
+	}
+
+	if (!res) {
+		res = icm42670_trigger_update_sources(dev);
+	}
+
+	if (res) {
+		sys_slist_find_and_remove(&data->consumers, &consumer->node);
+
+		/* nobody is left to drain a FIFO started for this consumer */
+		if (sys_slist_is_empty(&data->consumers)) {
+			(void)icm42670_fifo_release(dev, ICM42670_FIFO_OWNER_CONSUMERS);
+		}
+
+		(void)icm42670_consumer_update(dev);
+	}
+
+cleanup:
+	icm42670_unlock(dev);
+	return res;
+}
+
+int icm42670_consumer_remove(const struct device *dev, struct icm42670_consumer *consumer)
+{
+	struct icm42670_data *data = dev->data;
+	int res = 0;
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	if (!sys_slist_find_and_remove(&data->consumers, &consumer->node)) {
+		res = -ENOENT;
+		goto cleanup;
+	}
+
+	if (sys_slist_is_empty(&data->consumers)) {
+		res = icm42670_fifo_release(dev, ICM42670_FIFO_OWNER_CONSUMERS);
+	}
+
+	/* the remaining consumers may do with a lower rate */
+	if (!res) {
+		res = icm42670_consumer_update(dev);
+	}
+
+	if (!res) {
+		res = icm42670_trigger_update_sources(dev);
+	}
+
+cleanup:
+	icm42670_unlock(dev);
+	return res;
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_CONSUMER_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_CONSUMER_H_
+
+#include <zephyr/device.h>
+
+/**
+ * @brief drain the FIFO and feed every registered consumer
+ *
+ * Called from the interrupt thread on a FIFO watermark or full event.
+ *
+ * @param dev icm42670 device pointer
+ */
+void icm42670_consumer_drain(const struct device *dev);
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_CONSUMER_H_ */
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Division-free unit conversion. Every full scale gets a multiplier and a
+ * shift computed at build time, converting a sample is then one 32x32 bit
+ * multiply instead of a 64-bit division.
+ */
+
+#include <zephyr/sys/util.h>
+#include "icm42670.h"
+#include "icm42670_convert.h"
+#include "icm42670_reg.h"
+
+/*
+ * Accel, see datasheet section 3.2: the sensitivity halves with every FS_SEL
+ * step so the micro m/s^2 per LSB is SENSOR_G in Q(11 + fs_sel). +-16g is
+ * 156.9 m/s^2 and fits in 2^8, each halving of the range drops one bit, which
+ * makes the q31 multiplier the same for every range.
+ */
+#define ACCEL_Q31_SHIFT(sel)	(8 - (sel))
+#define ACCEL_Q31_MULT_SENS(s)	((uint32_t)(((uint64_t)SENSOR_G << (16 + 31 - (s) - 8)) / 1000000))
+#define ACCEL_Q31_MULT		ACCEL_Q31_MULT_SENS(MIN_ACCEL_SENS_SHIFT)
+
+#define ACCEL_SCALE(sel)						\
+	{								\
+		.micro_mult = SENSOR_G,					\
+		.micro_offset = 0,					\
+		.q31_mult = ACCEL_Q31_MULT,				\
+		.q31_offset = 0,					\
+		.micro_shift = MIN_ACCEL_SENS_SHIFT + (sel),		\
+		.q31_shift = ACCEL_Q31_SHIFT(sel),			\
+	}
+
+/*
+ * Gyro, see datasheet section 3.1: micro rad/s per LSB in Q16 from the
+ * sensitivity in LSB/(dps/10). +-2000dps is 34.9 rad/s and fits in 2^6.
+ */
+#define GYRO_MICRO_MULT_SENS(lsb, dps)	((uint32_t)(((uint64_t)SENSOR_PI * (dps) << 16) / \
+						    ((uint64_t)(lsb) * 180)))
+#define GYRO_MICRO_MULT(x10)	GYRO_MICRO_MULT_SENS(x10, 10)
+#define GYRO_Q31_SHIFT(sel)	(6 - (sel))
+#define GYRO_Q31_MULT_MICRO(m, sel)	((uint32_t)(((uint64_t)(m) << (31 - GYRO_Q31_SHIFT(sel))) / \
+						    1000000))
+#define GYRO_Q31_MULT(x10, sel)	GYRO_Q31_MULT_MICRO(GYRO_MICRO_MULT(x10), sel)
+
+#define GYRO_SCALE(x10, sel)						\
+	{								\
+		.micro_mult = GYRO_MICRO_MULT(x10),			\
+		.micro_offset = 0,					\
+		.q31_mult = GYRO_Q31_MULT(x10, sel),			\
+		.q31_offset = 0,					\
+		.micro_shift = 16,					\
+		.q31_shift = GYRO_Q31_SHIFT(sel),			\
+	}
+
+/* die temperature never exceeds 2^9 C, see datasheet section 15.9, T = raw / 128 + 25 */
+#define TEMP_Q31_SHIFT		9
+
+static const struct icm42670_scale icm42670_accel_scales[] = {
+	ACCEL_SCALE(BIT_ACCEL_UI_FS_16),
+	ACCEL_SCALE(BIT_ACCEL_UI_FS_8),
+	ACCEL_SCALE(BIT_ACCEL_UI_FS_4),
+	ACCEL_SCALE(BIT_ACCEL_UI_FS_2),
+};
+
+static const struct icm42670_scale icm42670_gyro_scales[] = {
+	GYRO_SCALE(164, BIT_GYRO_UI_FS_2000),
+	GYRO_SCALE(328, BIT_GYRO_UI_FS_1000),
+	GYRO_SCALE(655, BIT_GYRO_UI_FS_500),
+	GYRO_SCALE(1310, BIT_GYRO_UI_FS_250),
+};
+
+static const struct icm42670_scale icm42670_die_temp_scale = {
+	.micro_mult = 1000000 >> 6,
+	.micro_offset = 25 * 1000000,
+	.q31_mult = (uint32_t)BIT(16 + 31 - TEMP_Q31_SHIFT - 7),
+	.q31_offset = 25 * BIT(31 - TEMP_Q31_SHIFT),
+	.micro_shift = 1,
+	.q31_shift = TEMP_Q31_SHIFT,
+};
+
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+/*
+ * High resolution FIFO values, see datasheet section 6.1: MSB aligned
+ * 20-bit fields at 2^15 LSB/g and 262.144 LSB/dps, the q31 shifts are
+ * those of the widest ranges.
+ */
+#define GYRO_HIRES_MICRO_MULT	GYRO_MICRO_MULT_SENS(FIFO_HIRES_GYRO_SENS_X1000, 1000)
+
+static const struct icm42670_scale icm42670_accel_hires = {
+	.micro_mult = SENSOR_G,
+	.micro_offset = 0,
+	.q31_mult = ACCEL_Q31_MULT_SENS(FIFO_HIRES_ACCEL_SENS_SHIFT),
+	.q31_offset = 0,
+	.micro_shift = FIFO_HIRES_ACCEL_SENS_SHIFT,
+	.q31_shift = ACCEL_Q31_SHIFT(BIT_ACCEL_UI_FS_16),
+};
+
+static const struct icm42670_scale icm42670_gyro_hires = {
+	.micro_mult = GYRO_HIRES_MICRO_MULT,
+	.micro_offset = 0,
+	.q31_mult = GYRO_Q31_MULT_MICRO(GYRO_HIRES_MICRO_MULT, BIT_GYRO_UI_FS_2000),
+	.q31_offset = 0,
+	.micro_shift = 16,
+	.q31_shift = GYRO_Q31_SHIFT(BIT_GYRO_UI_FS_2000),
+};
+#endif
+
+const struct icm42670_scale *icm42670_accel_scale(uint8_t fs_sel)
+{
+	return &icm42670_accel_scales[fs_sel & (ARRAY_SIZE(icm42670_accel_scales) - 1)];
+}
+
+const struct icm42670_scale *icm42670_gyro_scale(uint8_t fs_sel)
+{
+	return &icm42670_gyro_scales[fs_sel & (ARRAY_SIZE(icm42670_gyro_scales) - 1)];
+}
+
+const struct icm42670_scale *icm42670_temp_scale(void)
+{
+	return &icm42670_die_temp_scale;
+}
+
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+const struct icm42670_scale *icm42670_accel_hires_scale(void)
+{
+	return &icm42670_accel_hires;
+}
+
+const struct icm42670_scale *icm42670_gyro_hires_scale(void)
+{
+	return &icm42670_gyro_hires;
+}
+
+int icm42670_get_hires_scale(enum sensor_channel chan, struct icm42670_scale *scale)
+{
+	switch (chan) {
+	case SENSOR_CHAN_ACCEL_X:
+	case SENSOR_CHAN_ACCEL_Y:
+	case SENSOR_CHAN_ACCEL_Z:
+	case SENSOR_CHAN_ACCEL_XYZ:
+		*scale = icm42670_accel_hires;
+		return 0;
+	case SENSOR_CHAN_GYRO_X:
+	case SENSOR_CHAN_GYRO_Y:
+	case SENSOR_CHAN_GYRO_Z:
+	case SENSOR_CHAN_GYRO_XYZ:
+		*scale = icm42670_gyro_hires;
+		return 0;
+	default:
+		return -ENOTSUP;
+	}
+}
+
+void icm42670_convert_hires_to_q31(const struct icm42670_scale *scale, const int32_t *raw,
+				   q31_t *out, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		out[i] = icm42670_scale_q31(scale, raw[i]);
+	}
+}
+#endif
+
+int icm42670_get_scale(const struct device *dev, enum sensor_channel chan,
+		       struct icm42670_scale *scale)
+{
+	struct icm42670_data *data = dev->data;
+
+	switch (chan) {
+	case SENSOR_CHAN_ACCEL_X:
+	case SENSOR_CHAN_ACCEL_Y:
+	case SENSOR_CHAN_ACCEL_Z:
+	case SENSOR_CHAN_ACCEL_XYZ:
+		*scale = *icm42670_accel_scale(data->accel_fs_sel);
+		return 0;
+	case SENSOR_CHAN_GYRO_X:
+	case SENSOR_CHAN_GYRO_Y:
+	case SENSOR_CHAN_GYRO_Z:
+	case SENSOR_CHAN_GYRO_XYZ:
+		*scale = *icm42670_gyro_scale(data->gyro_fs_sel);
+		return 0;
+	case SENSOR_CHAN_DIE_TEMP:
+		*scale = icm42670_die_temp_scale;
+		return 0;
+	default:
+		return -ENOTSUP;
+	}
+}
+
+void icm42670_convert_to_values(const struct icm42670_scale *scale, const int16_t *raw,
+				struct sensor_value *val, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		icm42670_scale_value(scale, raw[i], &val[i]);
+	}
+}
+
+void icm42670_convert_to_micro(const struct icm42670_scale *scale, const int16_t *raw,
+			       int32_t *micro, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		micro[i] = icm42670_scale_micro(scale, raw[i]);
+	}
+}
+
+void icm42670_convert_to_q31(const struct icm42670_scale *scale, const int16_t *raw, q31_t *out,
+			     size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		out[i] = icm42670_scale_q31(scale, raw[i]);
+	}
+}
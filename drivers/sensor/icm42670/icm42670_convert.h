@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_CONVERT_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_CONVERT_H_
+
+#include <stdint.h>
+#include <zephyr/drivers/sensor.h>
+#include <app/drivers/sensor/icm42670.h>
+
+/**
+ * @brief conversion constants of the accelerometer
+ *
+ * @param fs_sel ACCEL_UI_FS_SEL field value
+ * @return const struct icm42670_scale* constants for that full scale
+ */
+const struct icm42670_scale *icm42670_accel_scale(uint8_t fs_sel);
+
+/**
+ * @brief conversion constants of the gyroscope
+ *
+ * @param fs_sel GYRO_UI_FS_SEL field value
+ * @return const struct icm42670_scale* constants for that full scale
+ */
+const struct icm42670_scale *icm42670_gyro_scale(uint8_t fs_sel);
+
+/**
+ * @brief conversion constants of the die temperature register
+ *
+ * @return const struct icm42670_scale* constants for TEMP_DATA
+ */
+const struct icm42670_scale *icm42670_temp_scale(void);
+
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+/**
+ * @brief conversion constants of 20-bit accel FIFO values, +-16g at 2^15 LSB/g
+ *
+ * @return const struct icm42670_scale* constants for high resolution accel
+ */
+const struct icm42670_scale *icm42670_accel_hires_scale(void);
+
+/**
+ * @brief conversion constants of 20-bit gyro FIFO values, +-2000dps at 262.144 LSB/dps
+ *
+ * @return const struct icm42670_scale* constants for high resolution gyro
+ */
+const struct icm42670_scale *icm42670_gyro_hires_scale(void);
+#endif
+
+/* raw count to micro SI units, a multiply and a shift */
+static inline int32_t icm42670_scale_micro(const struct icm42670_scale *scale, int32_t raw)
+{
+	return (int32_t)(((int64_t)raw * scale->micro_mult) >> scale->micro_shift) +
+	       scale->micro_offset;
+}
+
+/* raw count to a q31 value with scale->q31_shift integer bits */
+static inline q31_t icm42670_scale_q31(const struct icm42670_scale *scale, int32_t raw)
+{
+	return (q31_t)(((int64_t)raw * scale->q31_mult) >> 16) + scale->q31_offset;
+}
+
+/* raw count to a sensor_value, the divide by a constant compiles to a multiply */
+static inline void icm42670_scale_value(const struct icm42670_scale *scale, int16_t raw,
+					struct sensor_value *val)
+{
+	int32_t micro = icm42670_scale_micro(scale, raw);
+
+	val->val1 = micro / 1000000;
+	val->val2 = micro - val->val1 * 1000000;
+}
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_CONVERT_H_ */
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define DT_DRV_COMPAT invensense_icm42670_temp
+
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/sys/byteorder.h>
+#include "icm42670_convert.h"
+#include "icm42670_decoder.h"
+#include "icm42670_fifo.h"
+#include "icm42670_reg.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ICM42670, CONFIG_SENSOR_LOG_LEVEL);
+
+/* byte offsets of the sensor data inside icm42670_encoded_data.readings */
+#define ICM42670_TEMP_OFFSET	0
+#define ICM42670_ACCEL_OFFSET	(ICM42670_TEMP_OFFSET + TEMP_DATA_SIZE)
+#define ICM42670_GYRO_OFFSET	(ICM42670_ACCEL_OFFSET + ACCEL_DATA_SIZE)
+
+static void icm42670_get_axes(const uint8_t *buf, int16_t *axes)
+{
+	axes[0] = (int16_t)sys_get_be16(&buf[0]);
+	axes[1] = (int16_t)sys_get_be16(&buf[2]);
+	axes[2] = (int16_t)sys_get_be16(&buf[4]);
+}
+
+/*
+ * Extract sample @p index from an encoded buffer, either the single register
+ * snapshot of a one-shot read or one of the packets of a FIFO drain.
+ */
+static int icm42670_get_frame(const uint8_t *buffer, uint16_t index,
+			      struct icm42670_fifo_frame *frame)
+{
+	const struct icm42670_encoded_header *header = (const struct icm42670_encoded_header *)buffer;
+
+	if (!header->is_fifo) {
+		const struct icm42670_encoded_data *edata = (const struct icm42670_encoded_data *)buffer;
+
+		if (index != 0) {
+			return -ENODATA;
+		}
+
+		frame->temp = (int16_t)sys_get_be16(&edata->readings[ICM42670_TEMP_OFFSET]);
+		icm42670_get_axes(&edata->readings[ICM42670_ACCEL_OFFSET], frame->accel);
+		icm42670_get_axes(&edata->readings[ICM42670_GYRO_OFFSET], frame->gyro);
+
+		return 0;
+	}
+
+#ifdef CONFIG_ICM42670_STREAM
+	const struct icm42670_fifo_data *fdata = (const struct icm42670_fifo_data *)buffer;
+
+	if (index >= fdata->fifo_count) {
+		return -ENODATA;
+	}
+
+	int res = icm42670_fifo_decode_packet(&fdata->packets[index * fdata->packet_size], frame);
+
+	return (res < 0) ? res : 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+/* high resolution FIFO packets carry 20-bit values at a fixed full scale */
+static bool icm42670_is_hires(const uint8_t *buffer)
+{
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+	const struct icm42670_encoded_header *header = (const struct icm42670_encoded_header *)buffer;
+
+	return header->is_fifo &&
+	       (((const struct icm42670_fifo_data *)buffer)->packet_size == FIFO_PACKET_SIZE_20);
+#else
+	ARG_UNUSED(buffer);
+
+	return false;
+#endif
+}
+
+/* accel and gyro counts of a frame, the 20-bit ones of a high resolution packet */
+static void icm42670_frame_raw(const struct icm42670_fifo_frame *frame, bool hires,
+			       int32_t *accel, int32_t *gyro)
+{
+	for (int i = 0; i < 3; i++) {
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+		if (hires) {
+			accel[i] = frame->accel_hires[i];
+			gyro[i] = frame->gyro_hires[i];
+			continue;
+		}
+#endif
+		accel[i] = frame->accel[i];
+		gyro[i] = frame->gyro[i];
+	}
+}
+
+static uint16_t icm42670_get_frame_total(const uint8_t *buffer)
+{
+	const struct icm42670_encoded_header *header = (const struct icm42670_encoded_header *)buffer;
+
+	if (!header->is_fifo) {
+		return 1;
+	}
+
+	return ((const struct icm42670_fifo_data *)buffer)->fifo_count;
+}
+
+static void icm42670_get_timing(const uint8_t *buffer, uint64_t *base_timestamp,
+				uint32_t *period)
+{
+	const struct icm42670_encoded_header *header = (const struct icm42670_encoded_header *)buffer;
+	uint16_t total = icm42670_get_frame_total(buffer);
+
+	*base_timestamp = header->timestamp;
+	*period = 0;
+
+	if (header->is_fifo && total > 0) {
+		*period = ((const struct icm42670_fifo_data *)buffer)->sample_period_ns;
+		/* the header timestamp belongs to the newest packet */
+		*base_timestamp -= (uint64_t)(total - 1) * *period;
+	}
+}
+
+static int icm42670_decoder_get_frame_count(const uint8_t *buffer,
+					    struct sensor_chan_spec chan_spec,
+					    uint16_t *frame_count)
+{
+	if (chan_spec.chan_idx != 0) {
+		return -ENOTSUP;
+	}
+
+	switch (chan_spec.chan_type) {
+	case SENSOR_CHAN_ACCEL_X:
+	case SENSOR_CHAN_ACCEL_Y:
+	case SENSOR_CHAN_ACCEL_Z:
+	case SENSOR_CHAN_ACCEL_XYZ:
+	case SENSOR_CHAN_GYRO_X:
+	case SENSOR_CHAN_GYRO_Y:
+	case SENSOR_CHAN_GYRO_Z:
+	case SENSOR_CHAN_GYRO_XYZ:
+	case SENSOR_CHAN_DIE_TEMP:
+		*frame_count = icm42670_get_frame_total(buffer);
+		return 0;
+	default:
+		return -ENOTSUP;
+	}
+}
+
+static int icm42670_decoder_get_size_info(struct sensor_chan_spec chan_spec, size_t *base_size,
+					  size_t *frame_size)
+{
+	switch (chan_spec.chan_type) {
+	case SENSOR_CHAN_ACCEL_XYZ:
+	case SENSOR_CHAN_GYRO_XYZ:
+		*base_size = sizeof(struct sensor_three_axis_data);
+		*frame_size = sizeof(struct sensor_three_axis_sample_data);
+		return 0;
+	case SENSOR_CHAN_ACCEL_X:
+	case SENSOR_CHAN_ACCEL_Y:
+	case SENSOR_CHAN_ACCEL_Z:
+	case SENSOR_CHAN_GYRO_X:
+	case SENSOR_CHAN_GYRO_Y:
+	case SENSOR_CHAN_GYRO_Z:
+	case SENSOR_CHAN_DIE_TEMP:
+		*base_size = sizeof(struct sensor_q31_data);
+		*frame_size = sizeof(struct sensor_q31_sample_data);
+		return 0;
+	default:
+		return -ENOTSUP;
+	}
+}
+
+static int icm42670_decoder_decode(const uint8_t *buffer, struct sensor_chan_spec chan_spec,
+				   uint32_t *fit, uint16_t max_count, void *data_out)
+{
+	const struct icm42670_encoded_header *header = (const struct icm42670_encoded_header *)buffer;
+	const struct icm42670_scale *accel = icm42670_accel_scale(header->accel_fs_sel);
+	const struct icm42670_scale *gyro = icm42670_gyro_scale(header->gyro_fs_sel);
+	const struct icm42670_scale *temp = icm42670_temp_scale();
+	bool hires = icm42670_is_hires(buffer);
+	struct icm42670_fifo_frame frame;
+	int32_t accel_raw[3];
+	int32_t gyro_raw[3];
+	uint32_t start = *fit;
+	uint64_t base_timestamp;
+	size_t base_size, frame_size;
+	uint32_t period;
+	uint16_t count = 0;
+
+	if (chan_spec.chan_idx != 0 ||
+	    icm42670_decoder_get_size_info(chan_spec, &base_size, &frame_size) != 0) {
+		return -ENOTSUP;
+	}
+
+	icm42670_get_timing(buffer, &base_timestamp, &period);
+
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+	if (hires) {
+		accel = icm42670_accel_hires_scale();
+		gyro = icm42670_gyro_hires_scale();
+	}
+#endif
+
+	/* both output layouts start with the same header */
+	struct sensor_data_header *out_header = data_out;
+
+	out_header->base_timestamp_ns = base_timestamp + (uint64_t)start * period;
+
+	while (count < max_count && icm42670_get_frame(buffer, *fit, &frame) == 0) {
+		icm42670_frame_raw(&frame, hires, accel_raw, gyro_raw);
+
+		switch (chan_spec.chan_type) {
+		case SENSOR_CHAN_ACCEL_XYZ: {
+			struct sensor_three_axis_data *out = data_out;
+
+			out->shift = accel->q31_shift;
+			out->readings[count].timestamp_delta = (*fit - start) * period;
+			out->readings[count].x = icm42670_scale_q31(accel, accel_raw[0]);
+			out->readings[count].y = icm42670_scale_q31(accel, accel_raw[1]);
+			out->readings[count].z = icm42670_scale_q31(accel, accel_raw[2]);
+			break;
+		}
+		case SENSOR_CHAN_GYRO_XYZ: {
+			struct sensor_three_axis_data *out = data_out;
+
+			out->shift = gyro->q31_shift;
+			out->readings[count].timestamp_delta = (*fit - start) * period;
+			out->readings[count].x = icm42670_scale_q31(gyro, gyro_raw[0]);
+			out->readings[count].y = icm42670_scale_q31(gyro, gyro_raw[1]);
+			out->readings[count].z = icm42670_scale_q31(gyro, gyro_raw[2]);
+			break;
+		}
+		case SENSOR_CHAN_ACCEL_X:
+		case SENSOR_CHAN_ACCEL_Y:
+		case SENSOR_CHAN_ACCEL_Z: {
+			struct sensor_q31_data *out = data_out;
+			int32_t raw = accel_raw[chan_spec.chan_type - SENSOR_CHAN_ACCEL_X];
+
+			out->shift = accel->q31_shift;
+			out->readings[count].timestamp_delta = (*fit - start) * period;
+			out->readings[count].value = icm42670_scale_q31(accel, raw);
+			break;
+		}
+		case SENSOR_CHAN_GYRO_X:
+		case SENSOR_CHAN_GYRO_Y:
+		case SENSOR_CHAN_GYRO_Z: {
+			struct sensor_q31_data *out = data_out;
+			int32_t raw = gyro_raw[chan_spec.chan_type - SENSOR_CHAN_GYRO_X];
+
+			out->shift = gyro->q31_shift;
+			out->readings[count].timestamp_delta = (*fit - start) * period;
+			out->readings[count].value = icm42670_scale_q31(gyro, raw);
+			break;
+		}
+		case SENSOR_CHAN_DIE_TEMP: {
+			struct sensor_q31_data *out = data_out;
+
+			out->shift = temp->q31_shift;
+			out->readings[count].timestamp_delta = (*fit - start) * period;
+			out->readings[count].temperature = icm42670_scale_q31(temp, frame.temp);
+			break;
+		}
+		default:
+			return -ENOTSUP;
+		}
+
+		(*fit)++;
+		count++;
+	}
+
+	out_header->reading_count = count;
+
+	return count;
+}
+
+static bool icm42670_decoder_has_trigger(const uint8_t *buffer, enum sensor_trigger_type trigger)
+{
+	const struct icm42670_encoded_header *header = (const struct icm42670_encoded_header *)buffer;
+
+	switch (trigger) {
+	case SENSOR_TRIG_DATA_READY:
+		return FIELD_GET(ICM42670_EVENT_DATA_READY, header->events);
+	case SENSOR_TRIG_FIFO_WATERMARK:
+		return FIELD_GET(ICM42670_EVENT_FIFO_THS, header->events);
+	case SENSOR_TRIG_FIFO_FULL:
+		return FIELD_GET(ICM42670_EVENT_FIFO_FULL, header->events);
+	default:
+		return false;
+	}
+}
+
+SENSOR_DECODER_API_DT_DEFINE() = {
+	.get_frame_count = icm42670_decoder_get_frame_count,
+	.get_size_info = icm42670_decoder_get_size_info,
+	.decode = icm42670_decoder_decode,
+	.has_trigger = icm42670_decoder_has_trigger,
+};
+
+uint16_t icm42670_encoded_config_gen(const uint8_t *buffer)
+{
+	const struct icm42670_encoded_header *header = (const struct icm42670_encoded_header *)buffer;
+
+	return header->config_gen;
+}
+
+int icm42670_get_decoder(const struct device *dev, const struct sensor_decoder_api **decoder)
+{
+	ARG_UNUSED(dev);
+
+	*decoder = &SENSOR_DECODER_NAME();
+
+	return 0;
+}
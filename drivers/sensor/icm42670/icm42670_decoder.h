@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_DECODER_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_DECODER_H_
+
+#include <stdint.h>
+#include <zephyr/drivers/sensor.h>
+#include "icm42670_reg.h"
+
+/* trigger events recorded in icm42670_encoded_header.events */
+#define ICM42670_EVENT_DATA_READY	BIT(0)
+#define ICM42670_EVENT_FIFO_THS		BIT(1)
+#define ICM42670_EVENT_FIFO_FULL	BIT(2)
+
+struct icm42670_encoded_header {
+	uint64_t timestamp;
+	uint8_t accel_fs_sel;
+	uint8_t gyro_fs_sel;
+	uint8_t is_fifo: 1;
+	uint8_t events: 7;
+	/* icm42670_data.config_gen at the time of the read */
+	uint16_t config_gen;
+};
+
+struct icm42670_encoded_data {
+	struct icm42670_encoded_header header;
+	/* big endian register contents, starting at REG_TEMP_DATA1 */
+	uint8_t readings[ALL_DATA_SIZE];
+};
+
+struct icm42670_fifo_data {
+	struct icm42670_encoded_header header;
+	/* time between two packets, the header timestamp belongs to the last one */
+	uint32_t sample_period_ns;
+	uint16_t fifo_count;
+	uint8_t packet_size;
+	/* raw FIFO packets as read from FIFO_DATA */
+	uint8_t packets[];
+};
+
+/** implement the get_decoder sensor api function */
+int icm42670_get_decoder(const struct device *dev, const struct sensor_decoder_api **decoder);
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_DECODER_H_ */
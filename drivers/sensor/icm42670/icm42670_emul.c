@@ -0,0 +1,781 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Emulator of the ICM42670 on I2C and SPI. Models the bank 0 registers, the
+ * MREG windows, data ready and the FIFO including overflow. Samples are
+ * produced lazily at the start of every bus transaction, for all sample
+ * periods that elapsed in emulated time since the previous one, so the FIFO
+ * fills at the configured rate without a timer.
+ */
+
+#define DT_DRV_COMPAT invensense_icm42670_temp
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/emul_sensor.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <app/drivers/sensor/icm42670_emul.h>
+#include "icm42670_reg.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(ICM42670_EMUL, CONFIG_SENSOR_LOG_LEVEL);
+
+#define EMUL_BANK0_SIZE		128
+#define EMUL_MREG_SIZE		256
+#define EMUL_MREG_BANKS		3
+#define EMUL_FIFO_EMPTY		0xff /* header with the MSG bit set */
+#define EMUL_ODR_1600_US	625
+#define EMUL_TEMP_SENS		128 /* LSB/C */
+#define EMUL_TEMP_OFFSET_C	25
+#define EMUL_TEMP_MIN_C		-40
+#define EMUL_TEMP_MAX_C		85
+#define EMUL_ACCEL_Q31_SHIFT	8 /* +-16g fits in +-256 m/s^2 */
+#define EMUL_GYRO_Q31_SHIFT	6 /* +-2000dps fits in +-64 rad/s */
+#define EMUL_TEMP_Q31_SHIFT	8
+
+struct icm42670_emul_data {
+	uint8_t bank0[EMUL_BANK0_SIZE];
+	uint8_t mreg[EMUL_MREG_BANKS][EMUL_MREG_SIZE];
+	/* register pointer of the I2C interface */
+	uint8_t cur_reg;
+	uint8_t fifo[FIFO_SIZE];
+	size_t fifo_head;
+	size_t fifo_len;
+	/* latched when FIFO_COUNTH is read, so COUNTL matches it */
+	uint16_t fifo_count;
+	/* emulated time of the last sample */
+	uint64_t sample_us;
+	struct icm42670_emul_sample sample;
+	icm42670_emul_waveform_t waveform;
+	void *waveform_data;
+};
+
+static uint8_t *icm42670_emul_mreg(struct icm42670_emul_data *data, uint8_t blk, uint8_t addr)
+{
+	static const uint8_t blocks[EMUL_MREG_BANKS] = {
+		FIELD_GET(REG_BANK_MASK, REG_MREG1_OFFSET),
+		FIELD_GET(REG_BANK_MASK, REG_MREG2_OFFSET),
+		FIELD_GET(REG_BANK_MASK, REG_MREG3_OFFSET),
+	};
+
+	for (int i = 0; i < EMUL_MREG_BANKS; i++) {
+		if (blocks[i] == blk) {
+			return &data->mreg[i][addr];
+		}
+	}
+
+	return NULL;
+}
+
+static uint8_t *icm42670_emul_reg(struct icm42670_emul_data *data, uint16_t reg)
+{
+	uint8_t bank = FIELD_GET(REG_BANK_MASK, reg);
+	uint8_t addr = FIELD_GET(REG_ADDRESS_MASK, reg);
+
+	if (bank) {
+		return icm42670_emul_mreg(data, bank, addr);
+	}
+
+	return (addr < EMUL_BANK0_SIZE) ? &data->bank0[addr] : NULL;
+}
+
+static bool icm42670_emul_accel_on(const struct icm42670_emul_data *data)
+{
+	return FIELD_GET(MASK_ACCEL_MODE, data->bank0[REG_PWR_MGMT0]) >= BIT_ACCEL_MODE_LPM;
+}
+
+static bool icm42670_emul_gyro_on(const struct icm42670_emul_data *data)
+{
+	return FIELD_GET(MASK_GYRO_MODE, data->bank0[REG_PWR_MGMT0]) == BIT_GYRO_MODE_LNM;
+}
+
+static uint32_t icm42670_emul_odr_period(uint8_t config0)
+{
+	uint8_t odr = CLAMP(FIELD_GET(MASK_ACCEL_ODR, config0), BIT_ACCEL_ODR_1600,
+			    BIT_ACCEL_ODR_1);
+
+	return EMUL_ODR_1600_US << (odr - BIT_ACCEL_ODR_1600);
+}
+
+/* a single sample clock at the rate of the faster running sensor, 0 while both are off */
+static uint32_t icm42670_emul_period(const struct icm42670_emul_data *data)
+{
+	uint32_t period = UINT32_MAX;
+
+	if (icm42670_emul_accel_on(data)) {
+		period = MIN(period, icm42670_emul_odr_period(data->bank0[REG_ACCEL_CONFIG0]));
+	}
+
+	if (icm42670_emul_gyro_on(data)) {
+		period = MIN(period, icm42670_emul_odr_period(data->bank0[REG_GYRO_CONFIG0]));
+	}
+
+	return (period == UINT32_MAX) ? 0 : period;
+}
+
+static uint8_t icm42670_emul_fifo_config5(struct icm42670_emul_data *data)
+{
+	return *icm42670_emul_reg(data, REG_FIFO_CONFIG5);
+}
+
+static size_t icm42670_emul_packet_size(struct icm42670_emul_data *data)
+{
+	uint8_t config5 = icm42670_emul_fifo_config5(data);
+	bool accel = FIELD_GET(BIT_FIFO_ACCEL_EN, config5);
+	bool gyro = FIELD_GET(BIT_FIFO_GYRO_EN, config5);
+
+	if (accel && gyro) {
+		return FIELD_GET(BIT_FIFO_HIRES_EN, config5) ? FIFO_PACKET_SIZE_20 :
+							       FIFO_PACKET_SIZE_16;
+	}
+
+	return (accel || gyro) ? FIFO_PACKET_SIZE_8 : 0;
+}
+
+static bool icm42670_emul_fifo_enabled(struct icm42670_emul_data *data)
+{
+	return !FIELD_GET(BIT_FIFO_BYPASS, data->bank0[REG_FIFO_CONFIG1]) &&
+	       icm42670_emul_packet_size(data);
+}
+
+static void icm42670_emul_fifo_flush(struct icm42670_emul_data *data)
+{
+	data->fifo_head = 0;
+	data->fifo_len = 0;
+	data->bank0[REG_FIFO_LOST_PKT0] = 0;
+	data->bank0[REG_FIFO_LOST_PKT1] = 0;
+}
+
+static void icm42670_emul_fifo_lost(struct icm42670_emul_data *data, uint64_t count)
+{
+	uint32_t lost = sys_get_le16(&data->bank0[REG_FIFO_LOST_PKT0]);
+
+	sys_put_le16(MIN(lost + count, UINT16_MAX), &data->bank0[REG_FIFO_LOST_PKT0]);
+}
+
+static uint16_t icm42670_emul_fifo_count(struct icm42670_emul_data *data)
+{
+	size_t size = icm42670_emul_packet_size(data);
+
+	if (FIELD_GET(BIT_FIFO_COUNT_FORMAT, data->bank0[REG_INTF_CONFIG0]) && size) {
+		return data->fifo_len / size;
+	}
+
+	return data->fifo_len;
+}
+
+static void icm42670_emul_fifo_push(struct icm42670_emul_data *data, const uint8_t *packet,
+				    size_t size)
+{
+	uint16_t wm = data->bank0[REG_FIFO_CONFIG2] |
+		      (FIELD_GET(MASK_FIFO_WM_H, data->bank0[REG_FIFO_CONFIG3]) << 8);
+
+	if (data->fifo_len + size > FIFO_SIZE) {
+		icm42670_emul_fifo_lost(data, 1);
+
+		/* stop-on-full mode drops the new packet */
+		if (FIELD_GET(BIT_FIFO_MODE, data->bank0[REG_FIFO_CONFIG1])) {
+			return;
+		}
+
+		/* stream mode makes room by dropping the oldest one */
+		data->fifo_head = (data->fifo_head + size) % FIFO_SIZE;
+		data->fifo_len -= MIN(size, data->fifo_len);
+	}
+
+	for (size_t i = 0; i < size; i++) {
+		data->fifo[(data->fifo_head + data->fifo_len + i) % FIFO_SIZE] = packet[i];
+	}
+
+	data->fifo_len += size;
+
+	if (data->fifo_len + size > FIFO_SIZE) {
+		data->bank0[REG_INT_STATUS] |= BIT_INT_STATUS_FIFO_FULL;
+	}
+
+	if (wm && (data->fifo_len / size >= wm)) {
+		data->bank0[REG_INT_STATUS] |= BIT_INT_STATUS_FIFO_THS;
+	}
+}
+
+static uint8_t icm42670_emul_fifo_pop(struct icm42670_emul_data *data)
+{
+	uint8_t val;
+
+	if (data->fifo_len == 0) {
+		return EMUL_FIFO_EMPTY;
+	}
+
+	val = data->fifo[data->fifo_head];
+	data->fifo_head = (data->fifo_head + 1) % FIFO_SIZE;
+	data->fifo_len--;
+
+	return val;
+}
+
+/* sensor data and FIFO contents follow the data endianness of INTF_CONFIG0 */
+static void icm42670_emul_put16(const struct icm42670_emul_data *data, int16_t val, uint8_t *dst)
+{
+	if (FIELD_GET(BIT_SENSOR_DATA_ENDIAN, data->bank0[REG_INTF_CONFIG0])) {
+		sys_put_be16(val, dst);
+	} else {
+		sys_put_le16(val, dst);
+	}
+}
+
+static void icm42670_emul_put_axes(const struct icm42670_emul_data *data, const int16_t *axes,
+				   uint8_t *dst)
+{
+	for (int i = 0; i < 3; i++) {
+		icm42670_emul_put16(data, axes[i], &dst[2 * i]);
+	}
+}
+
+/*
+ * MSB aligned 20-bit values at 2^15 LSB/g and 262.144 LSB/dps from counts at
+ * the configured full scale, @p lsb_zero low bits never carry data. The upper
+ * 16 bits go to the packet and the low nibble to @p ext.
+ */
+static void icm42670_emul_put_hires(const struct icm42670_emul_data *data, const int16_t *axes,
+				    int fs_sel, int lsb_zero, int nibble, uint8_t *dst,
+				    uint8_t *ext)
+{
+	for (int i = 0; i < 3; i++) {
+		/* +-16g and +-2000dps counts are the upper 16 of the 20 bits */
+		int32_t value = (((int32_t)axes[i] << 4) >> fs_sel) & ~(int32_t)BIT_MASK(lsb_zero);
+
+		icm42670_emul_put16(data, value >> 4, &dst[2 * i]);
+		ext[i] |= (value & 0x0f) << nibble;
+	}
+}
+
+/* see datasheet section 6.1 for the packet layouts */
+static size_t icm42670_emul_packet(struct icm42670_emul_data *data,
+				   const struct icm42670_emul_sample *sample, uint64_t time_us,
+				   uint8_t *packet)
+{
+	uint8_t config5 = icm42670_emul_fifo_config5(data);
+	uint8_t tmst_config = *icm42670_emul_reg(data, REG_TMST_CONFIG1);
+	int8_t temp = sample->temp / FIFO_TEMP8_SCALE;
+
+	memset(packet, 0, FIFO_PACKET_SIZE_20);
+
+	if (icm42670_emul_packet_size(data) == FIFO_PACKET_SIZE_20) {
+		packet[0] = BIT_FIFO_HEADER_ACCEL | BIT_FIFO_HEADER_GYRO | BIT_FIFO_HEADER_20;
+		icm42670_emul_put_hires(data, sample->accel,
+					FIELD_GET(MASK_ACCEL_UI_FS_SEL,
+						  data->bank0[REG_ACCEL_CONFIG0]),
+					2, 4, &packet[1], &packet[FIFO_EXT_OFFSET_20]);
+		icm42670_emul_put_hires(data, sample->gyro,
+					FIELD_GET(MASK_GYRO_UI_FS_SEL, data->bank0[REG_GYRO_CONFIG0]),
+					1, 0, &packet[7], &packet[FIFO_EXT_OFFSET_20]);
+		icm42670_emul_put16(data, sample->temp, &packet[FIFO_TEMP16_OFFSET_20]);
+
+		if (FIELD_GET(BIT_FIFO_TMST_FSYNC_EN, config5) &&
+		    FIELD_GET(BIT_TMST_EN, tmst_config)) {
+			packet[0] |= FIELD_PREP(MASK_FIFO_HEADER_TMST_FSYNC,
+						BIT_FIFO_HEADER_TMST_ODR);
+			icm42670_emul_put16(data, (uint16_t)time_us, &packet[FIFO_TMST_OFFSET_20]);
+		}
+
+		return FIFO_PACKET_SIZE_20;
+	}
+
+	if (icm42670_emul_packet_size(data) == FIFO_PACKET_SIZE_16) {
+		packet[0] = BIT_FIFO_HEADER_ACCEL | BIT_FIFO_HEADER_GYRO;
+		icm42670_emul_put_axes(data, sample->accel, &packet[1]);
+		icm42670_emul_put_axes(data, sample->gyro, &packet[7]);
+		packet[13] = temp;
+
+		if (FIELD_GET(BIT_FIFO_TMST_FSYNC_EN, config5) &&
+		    FIELD_GET(BIT_TMST_EN, tmst_config)) {
+			packet[0] |= FIELD_PREP(MASK_FIFO_HEADER_TMST_FSYNC,
+						BIT_FIFO_HEADER_TMST_ODR);
+			icm42670_emul_put16(data, (uint16_t)time_us, &packet[FIFO_TMST_OFFSET]);
+		}
+
+		return FIFO_PACKET_SIZE_16;
+	}
+
+	if (FIELD_GET(BIT_FIFO_ACCEL_EN, config5)) {
+		packet[0] = BIT_FIFO_HEADER_ACCEL;
+		icm42670_emul_put_axes(data, sample->accel, &packet[1]);
+	} else {
+		packet[0] = BIT_FIFO_HEADER_GYRO;
+		icm42670_emul_put_axes(data, sample->gyro, &packet[1]);
+	}
+
+	packet[7] = temp;
+
+	return FIFO_PACKET_SIZE_8;
+}
+
+static void icm42670_emul_produce(const struct emul *target, uint64_t time_us)
+{
+	struct icm42670_emul_data *data = target->data;
+	struct icm42670_emul_sample sample = data->sample;
+	uint8_t packet[FIFO_PACKET_SIZE_20];
+
+	if (data->waveform) {
+		data->waveform(target, time_us, &sample, data->waveform_data);
+	}
+
+	/* a sensor that is off reads as -32768 */
+	if (!icm42670_emul_accel_on(data)) {
+		sample.accel[0] = sample.accel[1] = sample.accel[2] = INT16_MIN;
+	}
+
+	if (!icm42670_emul_gyro_on(data)) {
+		sample.gyro[0] = sample.gyro[1] = sample.gyro[2] = INT16_MIN;
+	}
+
+	icm42670_emul_put16(data, sample.temp, &data->bank0[REG_TEMP_DATA1]);
+	icm42670_emul_put_axes(data, sample.accel, &data->bank0[REG_ACCEL_DATA_X1]);
+	icm42670_emul_put_axes(data, sample.gyro, &data->bank0[REG_GYRO_DATA_X1]);
+	data->bank0[REG_INT_STATUS_DRDY] |= BIT_INT_STATUS_DATA_DRDY;
+
+	if (icm42670_emul_fifo_enabled(data)) {
+		icm42670_emul_fifo_push(data, packet,
+					icm42670_emul_packet(data, &sample, time_us, packet));
+	}
+}
+
+/* produce the samples of all sample periods elapsed since the last transaction */
+static void icm42670_emul_advance(const struct emul *target)
+{
+	struct icm42670_emul_data *data = target->data;
+	uint64_t now = k_ticks_to_us_floor64(k_uptime_ticks());
+	uint32_t period = icm42670_emul_period(data);
+	uint64_t max = FIFO_SIZE / FIFO_PACKET_SIZE_8 + 1;
+	uint64_t count;
+
+	if (period == 0) {
+		/* the first sample comes one period after a sensor is turned on */
+		data->sample_us = now;
+		return;
+	}
+
+	count = (now - data->sample_us) / period;
+
+	/*
+	 * a sample that would only be pushed out of the FIFO again by the
+	 * ones after it is not computed, it just counts as lost
+	 */
+	if (count > max) {
+		if (icm42670_emul_fifo_enabled(data)) {
+			icm42670_emul_fifo_lost(data, count - max);
+		}
+
+		data->sample_us += (count - max) * period;
+		count = max;
+	}
+
+	for (uint64_t i = 0; i < count; i++) {
+		data->sample_us += period;
+		icm42670_emul_produce(target, data->sample_us);
+	}
+}
+
+static void icm42670_emul_reset(struct icm42670_emul_data *data)
+{
+	memset(data->bank0, 0, sizeof(data->bank0));
+	memset(data->mreg, 0, sizeof(data->mreg));
+
+	data->bank0[REG_WHO_AM_I] = WHO_AM_I_ICM42670;
+	data->bank0[REG_INTF_CONFIG0] = BIT_SENSOR_DATA_ENDIAN | BIT_FIFO_COUNT_ENDIAN;
+	data->bank0[REG_FIFO_CONFIG1] = BIT_FIFO_BYPASS;
+	data->bank0[REG_ACCEL_CONFIG0] = BIT_ACCEL_ODR_800;
+	data->bank0[REG_GYRO_CONFIG0] = BIT_GYRO_ODR_800;
+	data->bank0[REG_INT_STATUS] = BIT_INT_STATUS_RESET_DONE;
+
+	icm42670_emul_fifo_flush(data);
+}
+
+static uint8_t icm42670_emul_read_byte(struct icm42670_emul_data *data, uint8_t reg)
+{
+	bool big_endian = FIELD_GET(BIT_FIFO_COUNT_ENDIAN, data->bank0[REG_INTF_CONFIG0]);
+	uint8_t pwr = data->bank0[REG_PWR_MGMT0];
+	uint8_t *mreg;
+	uint8_t val;
+
+	if (reg >= EMUL_BANK0_SIZE) {
+		return 0;
+	}
+
+	val = data->bank0[reg];
+
+	switch (reg) {
+	case REG_MCLK_RDY:
+		/* the clock runs while idle is set or any sensor is on */
+		return (FIELD_GET(BIT_IDLE, pwr) || icm42670_emul_accel_on(data) ||
+			FIELD_GET(MASK_GYRO_MODE, pwr)) ? BIT_MCLK_RDY : 0;
+	case REG_INT_STATUS_DRDY:
+	case REG_INT_STATUS:
+	case REG_INT_STATUS2:
+	case REG_INT_STATUS3:
+		/* cleared on read */
+		data->bank0[reg] = 0;
+		return val;
+	case REG_FIFO_COUNTH:
+		data->fifo_count = icm42670_emul_fifo_count(data);
+		return big_endian ? (data->fifo_count >> 8) : (data->fifo_count & 0xff);
+	case REG_FIFO_COUNTL:
+		return big_endian ? (data->fifo_count & 0xff) : (data->fifo_count >> 8);
+	case REG_FIFO_DATA:
+		return icm42670_emul_fifo_pop(data);
+	case REG_APEX_DATA3:
+		/* the DMP completes any request right away */
+		return val | BIT_DMP_IDLE;
+	case REG_M_R:
+		mreg = icm42670_emul_mreg(data, data->bank0[REG_BLK_SEL_R],
+					  data->bank0[REG_MADDR_R]);
+		return mreg ? *mreg : 0;
+	default:
+		return val;
+	}
+}
+
+static void icm42670_emul_write_byte(struct icm42670_emul_data *data, uint8_t reg, uint8_t val)
+{
+	uint8_t *mreg;
+
+	if ((reg >= EMUL_BANK0_SIZE) || ((reg >= REG_TEMP_DATA1) && (reg <= REG_TMST_FSYNCL))) {
+		return;
+	}
+
+	switch (reg) {
+	case REG_SIGNAL_PATH_RESET:
+		if (FIELD_GET(BIT_SOFT_RESET, val)) {
+			icm42670_emul_reset(data);
+		}
+
+		if (FIELD_GET(BIT_FIFO_FLUSH, val)) {
+			icm42670_emul_fifo_flush(data);
+		}
+
+		/* both bits clear themselves */
+		return;
+	case REG_M_W:
+		mreg = icm42670_emul_mreg(data, data->bank0[REG_BLK_SEL_W],
+					  data->bank0[REG_MADDR_W]);
+
+		if (mreg) {
+			*mreg = val;
+		}
+
+		return;
+	case REG_FIFO_CONFIG1:
+		/* entering or leaving bypass empties the FIFO */
+		if (FIELD_GET(BIT_FIFO_BYPASS, val ^ data->bank0[reg])) {
+			icm42670_emul_fifo_flush(data);
+		}
+
+		break;
+	case REG_MCLK_RDY:
+	case REG_FIFO_LOST_PKT0:
+	case REG_FIFO_LOST_PKT1:
+	case REG_INT_STATUS_DRDY:
+	case REG_INT_STATUS:
+	case REG_INT_STATUS2:
+	case REG_INT_STATUS3:
+	case REG_FIFO_COUNTH:
+	case REG_FIFO_COUNTL:
+	case REG_FIFO_DATA:
+	case REG_WHO_AM_I:
+		/* read only */
+		return;
+	default:
+		break;
+	}
+
+	data->bank0[reg] = val;
+}
+
+/* the register address auto increments during a burst, except on FIFO_DATA */
+static uint8_t icm42670_emul_next(uint8_t reg)
+{
+	return (reg == REG_FIFO_DATA) ? reg : reg + 1;
+}
+
+static int icm42670_emul_transfer_i2c(const struct emul *target, struct i2c_msg *msgs,
+				      int num_msgs, int addr)
+{
+	struct icm42670_emul_data *data = target->data;
+	bool writing = false;
+
+	ARG_UNUSED(addr);
+
+	icm42670_emul_advance(target);
+
+	for (int i = 0; i < num_msgs; i++) {
+		struct i2c_msg *msg = &msgs[i];
+		uint32_t start = 0;
+
+		if (msg->flags & I2C_MSG_READ) {
+			for (uint32_t j = 0; j < msg->len; j++) {
+				msg->buf[j] = icm42670_emul_read_byte(data, data->cur_reg);
+				data->cur_reg = icm42670_emul_next(data->cur_reg);
+			}
+
+			writing = false;
+			continue;
+		}
+
+		/* the first byte written addresses the register, later messages continue the burst */
+		if (!writing && (msg->len > 0)) {
+			data->cur_reg = msg->buf[0];
+			start = 1;
+			writing = true;
+		}
+
+		for (uint32_t j = start; j < msg->len; j++) {
+			icm42670_emul_write_byte(data, data->cur_reg, msg->buf[j]);
+			data->cur_reg = icm42670_emul_next(data->cur_reg);
+		}
+	}
+
+	return 0;
+}
+
+static int icm42670_emul_io_spi(const struct emul *target, const struct spi_config *config,
+				const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs)
+{
+	struct icm42670_emul_data *data = target->data;
+	const struct spi_buf_set *bufs;
+	size_t skip = 1;
+	uint8_t reg;
+	bool read;
+
+	ARG_UNUSED(config);
+
+	if (!tx_bufs || (tx_bufs->count == 0) || (tx_bufs->buffers[0].len == 0)) {
+		return -EIO;
+	}
+
+	reg = ((const uint8_t *)tx_bufs->buffers[0].buf)[0];
+	read = FIELD_GET(REG_SPI_READ_BIT, reg);
+	reg &= ~REG_SPI_READ_BIT;
+	bufs = read ? rx_bufs : tx_bufs;
+
+	icm42670_emul_advance(target);
+
+	if (!bufs) {
+		return 0;
+	}
+
+	/* the first byte on either line is clocked while the address goes out */
+	for (size_t i = 0; i < bufs->count; i++) {
+		uint8_t *buf = bufs->buffers[i].buf;
+
+		for (size_t j = 0; j < bufs->buffers[i].len; j++) {
+			if (skip) {
+				skip--;
+				continue;
+			}
+
+			if (read) {
+				uint8_t val = icm42670_emul_read_byte(data, reg);
+
+				if (buf) {
+					buf[j] = val;
+				}
+			} else {
+				icm42670_emul_write_byte(data, reg, buf[j]);
+			}
+
+			reg = icm42670_emul_next(reg);
+		}
+	}
+
+	return 0;
+}
+
+/* value of a q31 number with the given shift, in millionths */
+static int64_t icm42670_emul_q31_to_micro(q31_t value, int8_t shift)
+{
+	return ((int64_t)value * 1000000) >> (31 - shift);
+}
+
+static int icm42670_emul_set_channel(const struct emul *target, struct sensor_chan_spec ch,
+				     const q31_t *value, int8_t shift)
+{
+	struct icm42670_emul_data *data = target->data;
+	uint8_t accel_fs = FIELD_GET(MASK_ACCEL_UI_FS_SEL, data->bank0[REG_ACCEL_CONFIG0]);
+	uint8_t gyro_fs = FIELD_GET(MASK_GYRO_UI_FS_SEL, data->bank0[REG_GYRO_CONFIG0]);
+	int64_t micro;
+	int64_t raw;
+	int16_t *dst;
+
+	if (!value || (shift > 31)) {
+		return -EINVAL;
+	}
+
+	micro = icm42670_emul_q31_to_micro(*value, shift);
+
+	switch (ch.chan_type) {
+	case SENSOR_CHAN_ACCEL_X:
+	case SENSOR_CHAN_ACCEL_Y:
+	case SENSOR_CHAN_ACCEL_Z:
+		raw = micro * BIT(MIN_ACCEL_SENS_SHIFT + accel_fs) / SENSOR_G;
+		dst = &data->sample.accel[ch.chan_type - SENSOR_CHAN_ACCEL_X];
+		break;
+	case SENSOR_CHAN_GYRO_X:
+	case SENSOR_CHAN_GYRO_Y:
+	case SENSOR_CHAN_GYRO_Z:
+		raw = micro * 180 * (MIN_GYRO_SENS_X10 << gyro_fs) / (SENSOR_PI * 10);
+		dst = &data->sample.gyro[ch.chan_type - SENSOR_CHAN_GYRO_X];
+		break;
+	case SENSOR_CHAN_DIE_TEMP:
+		raw = (micro - EMUL_TEMP_OFFSET_C * 1000000LL) * EMUL_TEMP_SENS / 1000000;
+		dst = &data->sample.temp;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	*dst = CLAMP(raw, INT16_MIN, INT16_MAX);
+
+	return 0;
+}
+
+static int icm42670_emul_get_sample_range(const struct emul *target, struct sensor_chan_spec ch,
+					  q31_t *lower, q31_t *upper, q31_t *epsilon,
+					  int8_t *shift)
+{
+	struct icm42670_emul_data *data = target->data;
+	uint8_t accel_fs = FIELD_GET(MASK_ACCEL_UI_FS_SEL, data->bank0[REG_ACCEL_CONFIG0]);
+	uint8_t gyro_fs = FIELD_GET(MASK_GYRO_UI_FS_SEL, data->bank0[REG_GYRO_CONFIG0]);
+
+	switch (ch.chan_type) {
+	case SENSOR_CHAN_ACCEL_X:
+	case SENSOR_CHAN_ACCEL_Y:
+	case SENSOR_CHAN_ACCEL_Z:
+	case SENSOR_CHAN_ACCEL_XYZ:
+		/* +-16g at FS_SEL 0, halving with every step */
+		*shift = EMUL_ACCEL_Q31_SHIFT;
+		*upper = ((16LL >> accel_fs) * SENSOR_G << (31 - EMUL_ACCEL_Q31_SHIFT)) / 1000000;
+		*epsilon = (SENSOR_G << (31 - EMUL_ACCEL_Q31_SHIFT)) /
+			   ((int64_t)BIT(MIN_ACCEL_SENS_SHIFT + accel_fs) * 1000000);
+		break;
+	case SENSOR_CHAN_GYRO_X:
+	case SENSOR_CHAN_GYRO_Y:
+	case SENSOR_CHAN_GYRO_Z:
+	case SENSOR_CHAN_GYRO_XYZ:
+		/* +-2000dps at FS_SEL 0, halving with every step */
+		*shift = EMUL_GYRO_Q31_SHIFT;
+		*upper = ((2000LL >> gyro_fs) * SENSOR_PI << (31 - EMUL_GYRO_Q31_SHIFT)) /
+			 (180LL * 1000000);
+		*epsilon = (10 * SENSOR_PI << (31 - EMUL_GYRO_Q31_SHIFT)) /
+			   (180LL * 1000000 * (MIN_GYRO_SENS_X10 << gyro_fs));
+		break;
+	case SENSOR_CHAN_DIE_TEMP:
+		*shift = EMUL_TEMP_Q31_SHIFT;
+		*lower = EMUL_TEMP_MIN_C * (int64_t)BIT(31 - EMUL_TEMP_Q31_SHIFT);
+		*upper = EMUL_TEMP_MAX_C * (int64_t)BIT(31 - EMUL_TEMP_Q31_SHIFT);
+		*epsilon = BIT(31 - EMUL_TEMP_Q31_SHIFT) / EMUL_TEMP_SENS;
+		return 0;
+	default:
+		return -ENOTSUP;
+	}
+
+	*lower = -*upper;
+
+	return 0;
+}
+
+static const struct emul_sensor_driver_api icm42670_emul_sensor_api = {
+	.set_channel = icm42670_emul_set_channel,
+	.get_sample_range = icm42670_emul_get_sample_range,
+};
+
+static const struct i2c_emul_api icm42670_emul_i2c_api = {
+	.transfer = icm42670_emul_transfer_i2c,
+};
+
+static const struct spi_emul_api icm42670_emul_spi_api = {
+	.io = icm42670_emul_io_spi,
+};
+
+void icm42670_emul_set_sample(const struct emul *target,
+			      const struct icm42670_emul_sample *sample)
+{
+	struct icm42670_emul_data *data = target->data;
+
+	data->sample = *sample;
+}
+
+void icm42670_emul_set_waveform(const struct emul *target, icm42670_emul_waveform_t waveform,
+				void *user_data)
+{
+	struct icm42670_emul_data *data = target->data;
+
+	data->waveform = waveform;
+	data->waveform_data = user_data;
+}
+
+void icm42670_emul_set_reg(const struct emul *target, uint16_t reg, const uint8_t *val,
+			   size_t count)
+{
+	struct icm42670_emul_data *data = target->data;
+
+	for (size_t i = 0; i < count; i++) {
+		uint8_t *dst = icm42670_emul_reg(data, reg + i);
+
+		if (dst) {
+			*dst = val[i];
+		}
+	}
+}
+
+void icm42670_emul_get_reg(const struct emul *target, uint16_t reg, uint8_t *val, size_t count)
+{
+	struct icm42670_emul_data *data = target->data;
+
+	for (size_t i = 0; i < count; i++) {
+		const uint8_t *src = icm42670_emul_reg(data, reg + i);
+
+		val[i] = src ? *src : 0;
+	}
+}
+
+size_t icm42670_emul_fifo_level(const struct emul *target)
+{
+	struct icm42670_emul_data *data = target->data;
+
+	return data->fifo_len;
+}
+
+static int icm42670_emul_init(const struct emul *target, const struct device *parent)
+{
+	struct icm42670_emul_data *data = target->data;
+
+	ARG_UNUSED(parent);
+
+	icm42670_emul_reset(data);
+	data->sample_us = k_ticks_to_us_floor64(k_uptime_ticks());
+
+	return 0;
+}
+
+#define ICM42670_EMUL_DEFINE(inst, bus_api)                                                        \
+	static struct icm42670_emul_data icm42670_emul_data_##inst;                                \
+	EMUL_DT_INST_DEFINE(inst, icm42670_emul_init, &icm42670_emul_data_##inst, NULL, &bus_api,  \
+			    &icm42670_emul_sensor_api)
+
+#define ICM42670_EMUL(inst)                                                                        \
+	COND_CODE_1(DT_INST_ON_BUS(inst, spi),                                                     \
+		    (ICM42670_EMUL_DEFINE(inst, icm42670_emul_spi_api)),                           \
+		    (ICM42670_EMUL_DEFINE(inst, icm42670_emul_i2c_api)))
+
+DT_INST_FOREACH_STATUS_OKAY(ICM42670_EMUL)
@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * FIFO streaming: samples are buffered on the sensor and drained in a single
+ * FIFO_DATA burst instead of one register read per sample.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include "icm42670.h"
+#include "icm42670_cache.h"
+#include "icm42670_convert.h"
+#include "icm42670_fifo.h"
+#include "icm42670_reg.h"
+#include "icm42670_tmst.h"
+#include "icm42670_trigger.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ICM42670, CONFIG_SENSOR_LOG_LEVEL);
+
+static void icm42670_fifo_get_axes(const uint8_t *buf, int16_t *axes)
+{
+	axes[0] = (int16_t)sys_get_be16(&buf[0]);
+	axes[1] = (int16_t)sys_get_be16(&buf[2]);
+	axes[2] = (int16_t)sys_get_be16(&buf[4]);
+}
+
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+/* upper 16 bits big endian, low nibbles of accel in the high and gyro in the low half */
+static void icm42670_fifo_get_hires(const uint8_t *buf, const uint8_t *ext, int shift,
+				    int32_t *axes)
+{
+	for (int i = 0; i < 3; i++) {
+		uint32_t value = ((uint32_t)sys_get_be16(&buf[2 * i]) << 4) |
+				 ((ext[i] >> shift) & 0x0f);
+
+		axes[i] = sign_extend(value, 19);
+	}
+}
+
+static int icm42670_fifo_decode_hires(const uint8_t *packet, struct icm42670_fifo_frame *frame)
+{
+	const uint8_t *ext = &packet[FIFO_EXT_OFFSET_20];
+
+	icm42670_fifo_get_hires(&packet[1], ext, 4, frame->accel_hires);
+	icm42670_fifo_get_hires(&packet[7], ext, 0, frame->gyro_hires);
+
+	/* the same samples at the +-16g and +-2000dps resolution of the 16-bit fields */
+	for (int i = 0; i < 3; i++) {
+		frame->accel[i] = frame->accel_hires[i] >> FIFO_HIRES_ACCEL_SHIFT;
+		frame->gyro[i] = frame->gyro_hires[i] >> FIFO_HIRES_GYRO_SHIFT;
+	}
+
+	/* full TEMP_DATA resolution instead of the 8-bit FIFO format */
+	frame->temp = (int16_t)sys_get_be16(&packet[FIFO_TEMP16_OFFSET_20]);
+
+	if (FIELD_GET(MASK_FIFO_HEADER_TMST_FSYNC, frame->header) == BIT_FIFO_HEADER_TMST_ODR) {
+		frame->tmst = sys_get_be16(&packet[FIFO_TMST_OFFSET_20]);
+	}
+
+	return FIFO_PACKET_SIZE_20;
+}
+#endif
+
+int icm42670_fifo_decode_packet(const uint8_t *packet, struct icm42670_fifo_frame *frame)
+{
+	uint8_t header = packet[0];
+
+	if (header & BIT_FIFO_HEADER_MSG) {
+		return -ENODATA;
+	}
+
+	memset(frame, 0, sizeof(*frame));
+	frame->header = header;
+
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+	if (FIELD_GET(BIT_FIFO_HEADER_20, header)) {
+		return icm42670_fifo_decode_hires(packet, frame);
+	}
+#endif
+
+	/* see datasheet section 6.1 for the packet layouts */
+	if (FIELD_GET(BIT_FIFO_HEADER_ACCEL, header) && FIELD_GET(BIT_FIFO_HEADER_GYRO, header)) {
+		icm42670_fifo_get_axes(&packet[1], frame->accel);
+		icm42670_fifo_get_axes(&packet[7], frame->gyro);
+		frame->temp = (int8_t)packet[13] * FIFO_TEMP8_SCALE;
+
+		if (FIELD_GET(MASK_FIFO_HEADER_TMST_FSYNC, header) == BIT_FIFO_HEADER_TMST_ODR) {
+			frame->tmst = sys_get_be16(&packet[FIFO_TMST_OFFSET]);
+		}
+
+		return FIFO_PACKET_SIZE_16;
+	}
+
+	if (FIELD_GET(BIT_FIFO_HEADER_ACCEL, header)) {
+		icm42670_fifo_get_axes(&packet[1], frame->accel);
+	} else {
+		icm42670_fifo_get_axes(&packet[1], frame->gyro);
+	}
+
+	frame->temp = (int8_t)packet[7] * FIFO_TEMP8_SCALE;
+
+	return FIFO_PACKET_SIZE_8;
+}
+
+int icm42670_fifo_set_watermark(const struct device *dev, uint16_t records)
+{
+	struct icm42670_data *data = dev->data;
+	uint8_t wm[2];
+	int res;
+
+	/*
+	 * a watermark of 0 is not allowed, and a batch must fit in the drain
+	 * buffer or a single drain leaves the FIFO above the watermark
+	 */
+	records = CLAMP(records, 1, sizeof(data->fifo_buf) / ICM42670_FIFO_PACKET_SIZE);
+
+	/* watermark low byte goes to FIFO_CONFIG2, the high nibble to FIFO_CONFIG3 */
+	wm[0] = (uint8_t)records;
+	wm[1] = (uint8_t)FIELD_PREP(MASK_FIFO_WM_H, records >> 8);
+
+	res = icm42670_reg_write_block(dev, REG_FIFO_CONFIG2, wm, sizeof(wm));
+
+	if (res) {
+		return res;
+	}
+
+	data->fifo_wm = records;
+
+	return 0;
+}
+
+int icm42670_fifo_start(const struct device *dev)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	/* report the FIFO count in records, big endian like the sensor data */
+	res = icm42670_reg_write(dev, REG_INTF_CONFIG0,
+				 BIT_FIFO_COUNT_FORMAT | BIT_FIFO_COUNT_ENDIAN |
+				 BIT_SENSOR_DATA_ENDIAN);
+
+	if (res) {
+		goto cleanup;
+	}
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+	/* absolute timestamps with 1 us resolution in every packet */
+	res = icm42670_reg_write(dev, REG_TMST_CONFIG1, BIT_TMST_EN);
+
+	if (res) {
+		goto cleanup;
+	}
+#endif
+
+	/*
+	 * accel and gyro together produce 16 byte packets, the timestamp comes
+	 * for free. High resolution packets take 4 bytes more for 20-bit values
+	 * at a fixed +-16g and +-2000dps full scale. The watermark interrupt
+	 * repeats while the count is at or above the threshold, not only when
+	 * it crosses it, so a partial drain does not stall the triggers.
+	 */
+	res = icm42670_reg_write(dev, REG_FIFO_CONFIG5,
+				 BIT_FIFO_ACCEL_EN | BIT_FIFO_GYRO_EN | BIT_FIFO_WM_GT_TH |
+				 (IS_ENABLED(CONFIG_ICM42670_TIMESTAMP) ? BIT_FIFO_TMST_FSYNC_EN : 0) |
+				 (IS_ENABLED(CONFIG_ICM42670_FIFO_HIRES) ? BIT_FIFO_HIRES_EN : 0));
+
+	if (res) {
+		goto cleanup;
+	}
+
+	/* the watermark is counted in records as well */
+	res = icm42670_fifo_set_watermark(dev, data->fifo_wm);
+
+	if (res) {
+		goto cleanup;
+	}
+
+	/* stream mode, leave bypass so the oldest packets are dropped when full */
+	res = icm42670_reg_write(dev, REG_FIFO_CONFIG1, 0);
+
+	if (res) {
+		goto cleanup;
+	}
+
+	res = icm42670_bus_write(cfg, REG_SIGNAL_PATH_RESET, BIT_FIFO_FLUSH);
+
+	if (res) {
+		goto cleanup;
+	}
+
+	data->fifo_packet_size = ICM42670_FIFO_PACKET_SIZE;
+	data->fifo_enabled = true;
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+	icm42670_tmst_init(&data->tmst);
+	data->tmst_fifo_empty = true;
+#endif
+
+cleanup:
+	icm42670_unlock(dev);
+	return res;
+}
+
+int icm42670_fifo_stop(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	res = icm42670_reg_write(dev, REG_FIFO_CONFIG1, BIT_FIFO_BYPASS);
+
+	if (res) {
+		goto cleanup;
+	}
+
+	res = icm42670_reg_write(dev, REG_FIFO_CONFIG5, 0);
+
+	if (res) {
+		goto cleanup;
+	}
+
+	data->fifo_enabled = false;
+	data->fifo_owners = 0;
+
+cleanup:
+	icm42670_unlock(dev);
+	return res;
+}
+
+int icm42670_fifo_claim(const struct device *dev, uint8_t owner)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	if (data->fifo_enabled) {
+		if (data->fifo_owners) {
+			data->fifo_owners |= owner;
+		}
+
+		return 0;
+	}
+
+	res = icm42670_fifo_start(dev);
+
+	if (!res) {
+		data->fifo_owners = owner;
+	}
+
+	return res;
+}
+
+int icm42670_fifo_release(const struct device *dev, uint8_t owner)
+{
+	struct icm42670_data *data = dev->data;
+
+	if (!(data->fifo_owners & owner)) {
+		return 0;
+	}
+
+	data->fifo_owners &= ~owner;
+
+	if (data->fifo_owners) {
+		return 0;
+	}
+
+	return icm42670_fifo_stop(dev);
+}
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+static void icm42670_fifo_timestamp(const struct device *dev, struct icm42670_fifo_frame *frames,
+				    size_t n, size_t fifo_count, uint64_t read_ns)
+{
+	struct icm42670_data *data = dev->data;
+	int64_t period = icm42670_tmst_period_ticks(dev);
+	uint64_t host_ns;
+	size_t anchor = icm42670_tmst_fifo_anchor(dev, n, fifo_count, read_ns, &host_ns);
+
+	icm42670_tmst_sync(&data->tmst, frames[anchor].tmst, host_ns);
+
+	for (size_t i = 0; i < n; i++) {
+		int64_t hint = ((int64_t)i - (int64_t)anchor) * period;
+
+		frames[i].timestamp_ns = icm42670_tmst_to_ns(&data->tmst, frames[i].tmst, hint);
+	}
+}
+#endif
+
+int icm42670_fifo_read(const struct device *dev, struct icm42670_fifo_frame *frames,
+		       size_t max_frames)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	uint8_t buffer[FIFO_COUNT_SIZE];
+	size_t count;
+	int res;
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	if (!data->fifo_enabled) {
+		res = -EINVAL;
+		goto cleanup;
+	}
+
+	res = icm42670_bus_read(cfg, REG_FIFO_COUNTH, buffer, FIFO_COUNT_SIZE);
+
+	if (res) {
+		goto cleanup;
+	}
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+	uint64_t read_ns = k_cyc_to_ns_floor64(k_cycle_get_64());
+#endif
+
+	count = sys_get_be16(buffer);
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+	size_t fifo_count = count;
+#endif
+
+	count = MIN(count, max_frames);
+	count = MIN(count, sizeof(data->fifo_buf) / data->fifo_packet_size);
+
+	if (count == 0) {
+		goto cleanup;
+	}
+
+	size_t len = count * data->fifo_packet_size;
+
+	res = icm42670_bus_read(cfg, REG_FIFO_DATA, data->fifo_buf, len);
+
+	if (res) {
+		goto cleanup;
+	}
+
+	size_t offset = 0;
+	size_t n = 0;
+	/* the FIFO is flushed on every rate or full scale change, all packets share them */
+	uint8_t accel_fs_sel = IS_ENABLED(CONFIG_ICM42670_FIFO_HIRES) ? 0 : data->accel_fs_sel;
+	uint8_t gyro_fs_sel = IS_ENABLED(CONFIG_ICM42670_FIFO_HIRES) ? 0 : data->gyro_fs_sel;
+
+	while ((n < count) && (offset < len)) {
+		int size = icm42670_fifo_decode_packet(&data->fifo_buf[offset], &frames[n]);
+
+		if (size < 0) {
+			break;
+		}
+
+		frames[n].config_gen = data->config_gen;
+		frames[n].accel_scale = icm42670_accel_scale(accel_fs_sel);
+		frames[n].gyro_scale = icm42670_gyro_scale(gyro_fs_sel);
+		offset += size;
+		n++;
+	}
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+	if (n > 0) {
+		icm42670_fifo_timestamp(dev, frames, n, fifo_count, read_ns);
+	}
+#endif
+
+	res = n;
+
+cleanup:
+	icm42670_unlock(dev);
+	return res;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_FIFO_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_FIFO_H_
+
+#include <stdint.h>
+#include <app/drivers/sensor/icm42670.h>
+#include "icm42670_reg.h"
+
+/* layout of the packets icm42670_fifo_start() sets the FIFO up for */
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+#define ICM42670_FIFO_PACKET_SIZE	FIFO_PACKET_SIZE_20
+#define ICM42670_FIFO_TMST_OFFSET	FIFO_TMST_OFFSET_20
+#else
+#define ICM42670_FIFO_PACKET_SIZE	FIFO_PACKET_SIZE_16
+#define ICM42670_FIFO_TMST_OFFSET	FIFO_TMST_OFFSET
+#endif
+
+/* parts of the driver starting the FIFO on their own, icm42670_data.fifo_owners */
+#define ICM42670_FIFO_OWNER_TRIGGER	BIT(0)
+#define ICM42670_FIFO_OWNER_STREAM	BIT(1)
+#define ICM42670_FIFO_OWNER_CONSUMERS	BIT(2)
+
+/**
+ * @brief parse a single FIFO packet
+ *
+ * @param packet start of the packet, the header byte
+ * @param frame destination frame
+ * @return int size of the packet in bytes, -ENODATA if the header marks
+ *         the FIFO as empty
+ */
+int icm42670_fifo_decode_packet(const uint8_t *packet, struct icm42670_fifo_frame *frame);
+
+/**
+ * @brief program the FIFO watermark, the caller must hold the driver lock
+ *
+ * @param dev icm42670 device pointer
+ * @param records watermark in FIFO records
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_fifo_set_watermark(const struct device *dev, uint16_t records);
+
+/**
+ * @brief start the FIFO on behalf of @p owner, the caller must hold the
+ *	  driver lock
+ *
+ * A FIFO already started by another owner is shared. One the application
+ * started with icm42670_fifo_start() is left to the application.
+ *
+ * @param dev icm42670 device pointer
+ * @param owner ICM42670_FIFO_OWNER_* bit
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_fifo_claim(const struct device *dev, uint8_t owner);
+
+/**
+ * @brief drop the claim of @p owner, stopping the FIFO when it was the last
+ *	  one, the caller must hold the driver lock
+ *
+ * @param dev icm42670 device pointer
+ * @param owner ICM42670_FIFO_OWNER_* bit
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_fifo_release(const struct device *dev, uint8_t owner);
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_FIFO_H_ */
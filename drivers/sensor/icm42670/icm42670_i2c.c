@@ -8,6 +8,7 @@
  * Bus-specific functionality for ICM42670 accessed via I2C.
  */
 
+#include <string.h>
 #include "icm42670.h"
 #include "icm42670_reg.h"
 
@@ -17,10 +18,32 @@ static int icm42670_bus_check_i2c(const union icm42670_bus *bus)
 	return i2c_is_ready_dt(&bus->i2c) ? 0 : -ENODEV;
 }
 
+static inline int i2c_write_regs(const union icm42670_bus *bus, uint8_t reg,
+				 const uint8_t *data, size_t len)
+{
+	uint8_t buf[4];
+
+	__ASSERT_NO_MSG(len < sizeof(buf));
+
+	/* a single write message, the register address auto-increments */
+	buf[0] = reg;
+	memcpy(&buf[1], data, len);
+
+	return i2c_write_dt(&bus->i2c, buf, len + 1);
+}
+
 static inline int i2c_read_mreg(const union icm42670_bus *bus, uint8_t reg, uint8_t bank,
 				uint8_t *buf, size_t len)
 {
-	int res = i2c_reg_write_byte_dt(&bus->i2c, REG_BLK_SEL_R, bank);
+	/* BLK_SEL_R and MADDR_R are contiguous, select bank and first address in one write */
+	uint8_t sel[2] = { bank, reg };
+	int res;
+
+	if (len == 0) {
+		return 0;
+	}
+
+	res = i2c_write_regs(bus, REG_BLK_SEL_R, sel, sizeof(sel));
 
 	if (res) {
 		return res;
@@ -28,28 +51,29 @@ static inline int i2c_read_mreg(const union icm42670_bus *bus, uint8_t reg, uint
 
 	/* reads from MREG registers must be done byte-by-byte */
 	for (size_t i = 0; i < len; i++) {
-		uint8_t addr = reg + i;
+		if (i > 0) {
+			res = i2c_reg_write_byte_dt(&bus->i2c, REG_MADDR_R, reg + i);
 
-		res = i2c_reg_write_byte_dt(&bus->i2c, REG_MADDR_R, addr);
-
-		if (res) {
-			return res;
+			if (res) {
+				return res;
+			}
 		}
 
-		k_usleep(MREG_R_W_WAIT_US);
+		/* the wait is far below a tick, spin rather than yield */
+		k_busy_wait(MREG_R_W_WAIT_US);
 		res = i2c_reg_read_byte_dt(&bus->i2c, REG_M_R, &buf[i]);
 
 		if (res) {
 			return res;
 		}
 
-		k_usleep(MREG_R_W_WAIT_US);
+		k_busy_wait(MREG_R_W_WAIT_US);
 	}
 
 	return 0;
 }
 
-static int icm42670_reg_read_i2c(const union icm42670_bus *bus, uint16_t reg, uint8_t *data,
+int icm42670_reg_read_i2c(const union icm42670_bus *bus, uint16_t reg, uint8_t *data,
 				 size_t len)
 {
 	int res = 0;
@@ -65,58 +89,86 @@ static int icm42670_reg_read_i2c(const union icm42670_bus *bus, uint16_t reg, ui
 	return res;
 }
 
-static inline int i2c_write_mreg(const union icm42670_bus *bus, uint16_t reg, uint8_t bank,
-				 uint8_t buf)
+static inline int i2c_write_mreg(const union icm42670_bus *bus, uint8_t reg, uint8_t bank,
+				 const uint8_t *buf, size_t len)
 {
-	int res = i2c_reg_write_byte_dt(&bus->i2c, REG_BLK_SEL_W, bank);
+	/* BLK_SEL_W, MADDR_W and M_W are contiguous, the first byte takes a single write */
+	uint8_t first[3] = { bank, reg, 0 };
+	int res;
 
-	if (res) {
-		return res;
+	if (len == 0) {
+		return 0;
 	}
 
-	res = i2c_reg_write_byte_dt(&bus->i2c, REG_MADDR_W, reg);
+	first[2] = buf[0];
+	res = i2c_write_regs(bus, REG_BLK_SEL_W, first, sizeof(first));
 
 	if (res) {
 		return res;
 	}
 
-	res = i2c_reg_write_byte_dt(&bus->i2c, REG_M_W, buf);
+	k_busy_wait(MREG_R_W_WAIT_US);
 
-	if (res) {
-		return res;
-	}
+	/* the bank stays selected, the following bytes only need MADDR_W and M_W */
+	for (size_t i = 1; i < len; i++) {
+		uint8_t next[2] = { reg + i, buf[i] };
 
-	k_usleep(MREG_R_W_WAIT_US);
+		res = i2c_write_regs(bus, REG_MADDR_W, next, sizeof(next));
+
+		if (res) {
+			return res;
+		}
+
+		k_busy_wait(MREG_R_W_WAIT_US);
+	}
 
 	return 0;
 }
 
-static int icm42670_reg_write_i2c(const union icm42670_bus *bus,
-				uint16_t reg, uint8_t data)
+int icm42670_reg_write_block_i2c(const union icm42670_bus *bus, uint16_t reg,
+					const uint8_t *data, size_t len)
 {
 	int res = 0;
 	uint8_t bank = FIELD_GET(REG_BANK_MASK, reg);
 	uint8_t address = FIELD_GET(REG_ADDRESS_MASK, reg);
 
 	if (bank) {
-		res = i2c_write_mreg(bus, address, bank, data);
+		res = i2c_write_mreg(bus, address, bank, data, len);
 	} else {
-		res = i2c_reg_write_byte_dt(&bus->i2c, address, data);
+		res = i2c_burst_write_dt(&bus->i2c, address, data, len);
 	}
 
 	return res;
 }
 
-static int icm42670_reg_update_i2c(const union icm42670_bus *bus, uint16_t reg, uint8_t mask,
+int icm42670_reg_write_i2c(const union icm42670_bus *bus,
+				uint16_t reg, uint8_t data)
+{
+	return icm42670_reg_write_block_i2c(bus, reg, &data, 1);
+}
+
+int icm42670_reg_update_i2c(const union icm42670_bus *bus, uint16_t reg, uint8_t mask,
 				   uint8_t val)
 {
-	return i2c_reg_update_byte_dt(&bus->i2c, reg, mask, val);
+	uint8_t temp = 0;
+	int res = icm42670_reg_read_i2c(bus, reg, &temp, 1);
+
+	if (res) {
+		return res;
+	}
+
+	/* same field semantics as the SPI update, and MREG aware */
+	temp &= ~mask;
+	temp |= FIELD_PREP(mask, val);
+
+	return icm42670_reg_write_i2c(bus, reg, temp);
 }
 
 const struct icm42670_bus_io icm42670_bus_io_i2c = {
 	.check = icm42670_bus_check_i2c,
 	.read = icm42670_reg_read_i2c,
 	.write = icm42670_reg_write_i2c,
+	.write_block = icm42670_reg_write_block_i2c,
 	.update = icm42670_reg_update_i2c,
 };
 #endif /* ICM42670_BUS_I2C */
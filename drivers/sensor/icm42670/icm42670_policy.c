@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Motion-adaptive rate policy. While the device lies still the accel runs
+ * slow in low power mode with the gyro in standby and only wake on motion
+ * can raise an interrupt. Motion switches to fast low noise sampling from
+ * the interrupt thread, and a periodic check drops back to idle once a
+ * whole period went by without motion.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include "icm42670.h"
+#include "icm42670_cache.h"
+#include "icm42670_policy.h"
+#include "icm42670_reg.h"
+#include "icm42670_trigger.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ICM42670, CONFIG_SENSOR_LOG_LEVEL);
+
+#define POLICY_MIN_ACTIVE_HZ	12 /* the slowest gyro rate */
+#define POLICY_MAX_ACTIVE_HZ	1600
+
+/* take a new reference sample for the wake on motion comparison */
+static int icm42670_policy_arm(const struct device *dev)
+{
+	int res = icm42670_reg_write(dev, REG_WOM_CONFIG, 0);
+
+	if (res) {
+		return res;
+	}
+
+	return icm42670_trigger_wom_config(dev);
+}
+
+/* add the time since the last switch to the current profile */
+static void icm42670_policy_account(struct icm42670_data *data)
+{
+	int64_t now = k_uptime_get();
+
+	data->profile_ms[data->profile] += now - data->profile_since;
+	data->profile_since = now;
+}
+
+/* switch to @p profile, the caller holds the driver lock */
+static int icm42670_policy_apply(const struct device *dev, uint8_t profile)
+{
+	struct icm42670_data *data = dev->data;
+	bool active = (profile == ICM42670_PROFILE_ACTIVE);
+	int res;
+
+	icm42670_policy_account(data);
+
+	if (active && (data->profile == ICM42670_PROFILE_IDLE)) {
+		data->policy_wakeups++;
+	}
+
+	data->profile = profile;
+	data->policy_motion = false;
+
+	/* the gyro keeps its rate in standby, waking it up is then a single write */
+	data->accel_power_mode = active ? ICM42670_ACCEL_POWER_LN : ICM42670_ACCEL_POWER_LP;
+	res = icm42670_set_odr(dev, active ? data->policy.active_hz : data->policy.idle_hz,
+			       data->policy.active_hz);
+
+	if (res) {
+		return res;
+	}
+
+	res = icm42670_update_accel_power(dev);
+
+	if (res) {
+		return res;
+	}
+
+	res = icm42670_gyro_standby(dev, !active);
+
+	if (res) {
+		return res;
+	}
+
+	res = icm42670_policy_arm(dev);
+
+	if (res) {
+		return res;
+	}
+
+	/* wake on motion only interrupts the host in the idle profile */
+	res = icm42670_trigger_update_sources(dev);
+
+	if (!res && active) {
+		k_work_reschedule(&data->policy_work, K_MSEC(data->policy.idle_after_ms));
+	}
+
+	return res;
+}
+
+/* go back to the settings from before the policy started, the caller holds the driver lock */
+static int icm42670_policy_restore(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	data->accel_power_mode = data->policy_prev_power_mode;
+	res = icm42670_set_odr(dev, data->policy_prev_accel_hz, data->policy_prev_gyro_hz);
+
+	if (res) {
+		return res;
+	}
+
+	res = icm42670_update_accel_power(dev);
+
+	if (res) {
+		return res;
+	}
+
+	res = icm42670_gyro_standby(dev, false);
+
+	if (res) {
+		return res;
+	}
+
+	/* nobody else uses wake on motion, this turns it off */
+	res = icm42670_trigger_wom_config(dev);
+
+	if (res) {
+		return res;
+	}
+
+	return icm42670_trigger_update_sources(dev);
+}
+
+static void icm42670_policy_work_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct icm42670_data *data = CONTAINER_OF(dwork, struct icm42670_data, policy_work);
+	const struct device *dev = data->dev;
+	const struct icm42670_config *cfg = dev->config;
+	uint8_t status2;
+	int res;
+
+	icm42670_lock(dev);
+
+	/* a suspended device keeps its registers until the resume re-applies the profile */
+	if (!data->policy_running || data->suspended ||
+	    (data->profile != ICM42670_PROFILE_ACTIVE)) {
+		goto cleanup;
+	}
+
+	/* wake on motion is not routed in the active profile, but its status still latches */
+	res = icm42670_bus_read(cfg, REG_INT_STATUS2, &status2, 1);
+
+	if (res) {
+		k_work_reschedule(&data->policy_work, K_MSEC(data->policy.idle_after_ms));
+	} else if (data->policy_motion || (status2 & MASK_INT_STATUS_WOM)) {
+		/* still moving, compare the next period with where the device is now */
+		data->policy_motion = false;
+		res = icm42670_policy_arm(dev);
+		k_work_reschedule(&data->policy_work, K_MSEC(data->policy.idle_after_ms));
+	} else {
+		res = icm42670_policy_apply(dev, ICM42670_PROFILE_IDLE);
+	}
+
+	if (res) {
+		LOG_ERR("motion policy check failed (%d)", res);
+	}
+
+cleanup:
+	icm42670_unlock(dev);
+}
+
+void icm42670_policy_init(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+
+	k_work_init_delayable(&data->policy_work, icm42670_policy_work_handler);
+}
+
+void icm42670_policy_motion(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	if (!data->policy_running || data->suspended) {
+		return;
+	}
+
+	if (data->profile == ICM42670_PROFILE_ACTIVE) {
+		data->policy_motion = true;
+		return;
+	}
+
+	res = icm42670_policy_apply(dev, ICM42670_PROFILE_ACTIVE);
+
+	if (res) {
+		LOG_ERR("switching to the active profile failed (%d)", res);
+	}
+}
+
+void icm42670_policy_suspend(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+
+	k_work_cancel_delayable(&data->policy_work);
+}
+
+int icm42670_policy_resume(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+
+	if (!data->policy_running) {
+		return 0;
+	}
+
+	/* powering up sets the gyro running and drops the wake on motion reference */
+	return icm42670_policy_apply(dev, data->profile);
+}
+
+int icm42670_motion_policy_start(const struct device *dev,
+				 const struct icm42670_motion_policy *policy)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	if ((policy->idle_hz < 1) || (policy->idle_hz > MAX_ACCEL_LP_ODR) ||
+	    (policy->active_hz < POLICY_MIN_ACTIVE_HZ) ||
+	    (policy->active_hz > POLICY_MAX_ACTIVE_HZ) || (policy->idle_after_ms == 0)) {
+		return -EINVAL;
+	}
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	if (data->policy_running || data->motion_handler) {
+		res = -EBUSY;
+		goto cleanup;
+	}
+
+	data->policy = *policy;
+	data->policy_prev_power_mode = data->accel_power_mode;
+	data->policy_prev_accel_hz = data->accel_hz;
+	data->policy_prev_gyro_hz = data->gyro_hz;
+	memset(data->profile_ms, 0, sizeof(data->profile_ms));
+	data->policy_wakeups = 0;
+	data->profile = ICM42670_PROFILE_ACTIVE;
+	data->profile_since = k_uptime_get();
+	data->policy_running = true;
+
+	/* start active, the first check drops to idle if nothing moves */
+	res = icm42670_policy_apply(dev, ICM42670_PROFILE_ACTIVE);
+
+	if (res) {
+		data->policy_running = false;
+		k_work_cancel_delayable(&data->policy_work);
+		(void)icm42670_policy_restore(dev);
+	}
+
+cleanup:
+	icm42670_unlock(dev);
+	return res;
+}
+
+int icm42670_motion_policy_stop(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
+	}
+
+	icm42670_lock(dev);
+
+	if (!data->policy_running) {
+		res = -EALREADY;
+		goto cleanup;
+	}
+
+	icm42670_policy_account(data);
+	data->policy_running = false;
+	k_work_cancel_delayable(&data->policy_work);
+
+	res = icm42670_policy_restore(dev);
+
+cleanup:
+	icm42670_unlock(dev);
+	return res;
+}
+
+void icm42670_motion_policy_stats_get(const struct device *dev,
+				      struct icm42670_motion_policy_stats *stats)
+{
+	struct icm42670_data *data = dev->data;
+
+	icm42670_lock(dev);
+
+	if (data->policy_running) {
+		icm42670_policy_account(data);
+	}
+
+	memcpy(stats->time_ms, data->profile_ms, sizeof(stats->time_ms));
+	stats->wakeups = data->policy_wakeups;
+	stats->profile = data->profile;
+
+	icm42670_unlock(dev);
+}
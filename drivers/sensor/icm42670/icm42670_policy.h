@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_POLICY_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_POLICY_H_
+
+#include <zephyr/device.h>
+
+/**
+ * @brief initialize the motion policy state of an instance
+ *
+ * @param dev icm42670 device pointer
+ */
+void icm42670_policy_init(const struct device *dev);
+
+/**
+ * @brief wake on motion fired, the caller must hold the driver lock
+ *
+ * Switches to the active profile, or notes the motion for the next idle
+ * check when already there.
+ *
+ * @param dev icm42670 device pointer
+ */
+void icm42670_policy_motion(const struct device *dev);
+
+/**
+ * @brief stop the idle checks while the device is suspended
+ *
+ * The caller must hold the driver lock.
+ *
+ * @param dev icm42670 device pointer
+ */
+void icm42670_policy_suspend(const struct device *dev);
+
+/**
+ * @brief re-apply the current profile after the device resumed
+ *
+ * The caller must hold the driver lock.
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_policy_resume(const struct device *dev);
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_POLICY_H_ */
@@ -187,9 +187,68 @@
 #define BIT_INT_FSYNC_INT1_EN		BIT(6)
 #define BIT_INT_ST_INT1_EN		BIT(7)
 
+/* Bank0 REG_INT_SOURCE1 */
+#define BIT_INT_WOM_X_INT1_EN		BIT(0)
+#define BIT_INT_WOM_Y_INT1_EN		BIT(1)
+#define BIT_INT_WOM_Z_INT1_EN		BIT(2)
+#define MASK_INT_WOM_INT1_EN		GENMASK(2, 0)
+#define BIT_INT_SMD_INT1_EN		BIT(3)
+
+/* Bank0 REG_WOM_CONFIG */
+#define BIT_WOM_EN			BIT(0)
+#define BIT_WOM_MODE			BIT(1)
+#define BIT_WOM_INT_MODE		BIT(2)
+#define MASK_WOM_INT_DUR		GENMASK(4, 3)
+
+/* Bank0 REG_APEX_CONFIG0 */
+#define MASK_DMP_MEM_RESET		GENMASK(1, 0)
+#define BIT_DMP_MEM_RESET_APEX_ST	0x01
+#define BIT_DMP_INIT_EN			BIT(2)
+#define BIT_DMP_POWER_SAVE_EN		BIT(3)
+
+/* Bank0 REG_APEX_CONFIG1 */
+#define MASK_DMP_ODR			GENMASK(1, 0)
+#define BIT_DMP_ODR_25			0x00
+#define BIT_DMP_ODR_400			0x01
+#define BIT_DMP_ODR_50			0x02
+#define BIT_DMP_ODR_100			0x03
+#define BIT_PED_ENABLE			BIT(3)
+#define BIT_TILT_ENABLE			BIT(4)
+#define BIT_FF_ENABLE			BIT(5)
+#define BIT_SMD_ENABLE			BIT(6)
+
+/* Bank0 REG_APEX_DATA3 */
+#define MASK_ACTIVITY_CLASS		GENMASK(1, 0)
+#define BIT_DMP_IDLE			BIT(2)
+
+/* MREG1 REG_INT_SOURCE6 */
+#define BIT_INT_TILT_DET_INT1_EN	BIT(3)
+#define BIT_INT_STEP_CNT_OVFL_INT1_EN	BIT(4)
+#define BIT_INT_STEP_DET_INT1_EN	BIT(5)
+#define BIT_INT_LOWG_INT1_EN		BIT(6)
+#define BIT_INT_FF_INT1_EN		BIT(7)
+
 /* Bank0 REG_INT_STATUS_DRDY */
 #define BIT_INT_STATUS_DATA_DRDY	BIT(0)
 
+/* MREG1 REG_INT_CONFIG0 */
+#define MASK_DRDY_INT_CLEAR		GENMASK(5, 4)
+#define BIT_DRDY_INT_CLEAR_STATUS	0x00
+#define BIT_DRDY_INT_CLEAR_DATA		0x02
+#define BIT_DRDY_INT_CLEAR_BOTH		0x03
+
+/* Bank0 REG_FIFO_CONFIG1 */
+#define BIT_FIFO_BYPASS			BIT(0)
+#define BIT_FIFO_MODE			BIT(1)
+
+/* Bank0 REG_FIFO_CONFIG3 */
+#define MASK_FIFO_WM_H			GENMASK(3, 0)
+
+/* Bank0 REG_INTF_CONFIG0 */
+#define BIT_SENSOR_DATA_ENDIAN		BIT(4)
+#define BIT_FIFO_COUNT_ENDIAN		BIT(5)
+#define BIT_FIFO_COUNT_FORMAT		BIT(6)
+
 /* Bank9 REG_INTF_CONFIG1 */
 #define BIT_I3C_SDR_EN			BIT(3)
 #define BIT_I3C_DDR_EN			BIT(2)
@@ -211,6 +270,7 @@
 #define BIT_INT_STATUS_WOM_Z		BIT(0)
 #define BIT_INT_STATUS_WOM_Y		BIT(1)
 #define BIT_INT_STATUS_WOM_X		BIT(2)
+#define MASK_INT_STATUS_WOM		GENMASK(2, 0)
 #define BIT_INT_STATUS_SMD		BIT(3)
 
 /* Bank0 REG_INT_STATUS3 */
@@ -255,14 +315,83 @@
 #define BIT_GYRO_ODR_25			0x0B
 #define BIT_GYRO_ODR_12			0x0C
 
+/* Bank0 REG_ACCEL_CONFIG1 */
+#define MASK_ACCEL_UI_AVG		GENMASK(6, 4)
+#define BIT_ACCEL_UI_AVG_2		0x00
+#define BIT_ACCEL_UI_AVG_4		0x01
+#define BIT_ACCEL_UI_AVG_8		0x02
+#define BIT_ACCEL_UI_AVG_16		0x03
+#define BIT_ACCEL_UI_AVG_32		0x04
+#define BIT_ACCEL_UI_AVG_64		0x05
+#define MASK_ACCEL_UI_FILT_BW		GENMASK(2, 0)
+
+/* MREG1 REG_TMST_CONFIG1 */
+#define BIT_TMST_EN			BIT(0)
+#define BIT_TMST_FSYNC_EN		BIT(1)
+#define BIT_TMST_DELTA_EN		BIT(2)
+#define BIT_TMST_RES			BIT(3)
+
+/* MREG1 REG_FIFO_CONFIG5 */
+#define BIT_FIFO_ACCEL_EN		BIT(0)
+#define BIT_FIFO_GYRO_EN		BIT(1)
+#define BIT_FIFO_TMST_FSYNC_EN		BIT(2)
+#define BIT_FIFO_HIRES_EN		BIT(3)
+#define BIT_FIFO_RESUME_PARTIAL_RD	BIT(4)
+#define BIT_FIFO_WM_GT_TH		BIT(5)
+
+/* FIFO packet header, see datasheet section 6.1 */
+#define BIT_FIFO_HEADER_ODR_GYRO	BIT(0)
+#define BIT_FIFO_HEADER_ODR_ACCEL	BIT(1)
+#define MASK_FIFO_HEADER_TMST_FSYNC	GENMASK(3, 2)
+#define BIT_FIFO_HEADER_TMST_ODR	0x02
+#define BIT_FIFO_HEADER_20		BIT(4)
+#define BIT_FIFO_HEADER_GYRO		BIT(5)
+#define BIT_FIFO_HEADER_ACCEL		BIT(6)
+#define BIT_FIFO_HEADER_MSG		BIT(7)
+
 /* misc. defines */
 #define WHO_AM_I_ICM42670		0x67
 #define MIN_ACCEL_SENS_SHIFT		11
+#define MIN_GYRO_SENS_X10		164 /* LSB per 10 dps at +-2000dps */
+#define MAX_ACCEL_LP_ODR		400
+#define WOM_THR_PER_G			256 /* ACCEL_WOM_x_THR resolution is 1g/256 */
+#define MAX_WOM_DUR			4 /* consecutive samples above the threshold */
+#define APEX_DATA_SIZE			4 /* APEX_DATA0..3, step count, cadence and activity */
+#define MIN_DMP_ODR			25
+#define DMP_POLL_INTERVAL_MS		1
+#define DMP_POLL_ATTEMPTS		50
 #define ACCEL_DATA_SIZE			6
 #define GYRO_DATA_SIZE			6
 #define TEMP_DATA_SIZE			2
+#define ALL_DATA_SIZE			(TEMP_DATA_SIZE + ACCEL_DATA_SIZE + GYRO_DATA_SIZE)
 #define MCLK_POLL_INTERVAL_US		250
 #define MCLK_POLL_ATTEMPTS		100
 #define SOFT_RESET_TIME_MS		2 /* 1ms + elbow room */
+#define POWER_UP_TIME_MS		3 /* supply ramp, covers the 1ms POR start up */
+#define ACCEL_STARTUP_TIME_MS		20 /* 10ms from off, with margin */
+#define GYRO_STARTUP_TIME_MS		45 /* 30ms from off, with margin */
+#define GYRO_STBY_EXIT_TIME_MS		5 /* drive kept running, only the output restarts */
+#define MODE_SWITCH_TIME_US		200 /* no register writes after leaving the off mode */
+#define FIFO_COUNT_SIZE			2
+#define FIFO_SIZE			2304
+#define FIFO_PACKET_SIZE_8		8  /* header + accel or gyro + temp */
+#define FIFO_PACKET_SIZE_16		16 /* header + accel + gyro + temp + timestamp */
+#define FIFO_PACKET_SIZE_20		20 /* 16 byte packet with 16-bit temp + 20-bit extension */
+#define FIFO_TMST_OFFSET		14 /* timestamp field of a 16 byte packet */
+#define FIFO_TEMP16_OFFSET_20		13 /* 16-bit temp field of a 20 byte packet */
+#define FIFO_TMST_OFFSET_20		15 /* timestamp field of a 20 byte packet */
+#define FIFO_EXT_OFFSET_20		17 /* accel and gyro low nibbles of a 20 byte packet */
+/* 20-bit FIFO values are MSB aligned, 18 accel and 19 gyro bits with the low bits zero */
+#define FIFO_HIRES_ACCEL_SHIFT		4 /* 32768 LSB/g, 20-bit to +-16g 16-bit counts */
+#define FIFO_HIRES_GYRO_SHIFT		4 /* 262.144 LSB/dps, 20-bit to +-2000dps 16-bit counts */
+#define FIFO_HIRES_ACCEL_SENS_SHIFT	15 /* 2^15 LSB/g */
+#define FIFO_HIRES_GYRO_SENS_X1000	262144 /* LSB per 1000 dps */
+#define FIFO_TEMP8_SCALE		64 /* 8-bit FIFO temp (2 LSB/C) to register scale */
+#define OFFSET_USER_SIZE		9 /* OFFSET_USER0..8, six packed 12-bit offsets */
+#define OFFSET_USER_MAX			2047
+#define OFFSET_ACCEL_PER_G		2000 /* 0.5 mg resolution */
+#define OFFSET_GYRO_PER_DPS		32 /* 1/32 dps resolution */
+#define CALIB_BATCH_SIZE		16 /* FIFO frames drained per read while calibrating */
+#define CALIB_TIMEOUT_MARGIN_MS		100
 
 #endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_REG_H_ */
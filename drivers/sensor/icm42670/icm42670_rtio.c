@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Asynchronous reads: requests are queued by icm42670_submit() and served
+ * from the system work queue, so the caller does not wait for the bus.
+ */
+
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/sys/mpsc_lockfree.h>
+#include "icm42670.h"
+#include "icm42670_decoder.h"
+#include "icm42670_reg.h"
+#include "icm42670_rtio.h"
+#include "icm42670_trigger.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ICM42670, CONFIG_SENSOR_LOG_LEVEL);
+
+void icm42670_submit_one_shot(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe,
+			      uint8_t events)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	const uint32_t min_buf_len = sizeof(struct icm42670_encoded_data);
+	struct icm42670_encoded_data *edata;
+	uint32_t buf_len;
+	uint8_t *buf;
+	int res;
+
+	res = rtio_sqe_rx_buf(iodev_sqe, min_buf_len, min_buf_len, &buf, &buf_len);
+
+	if (res) {
+		LOG_ERR("Failed to get a read buffer of size %u bytes", min_buf_len);
+		rtio_iodev_sqe_err(iodev_sqe, res);
+		return;
+	}
+
+	/* the registers and the scale they are tagged with must belong together */
+	icm42670_lock(dev);
+	icm42670_wait_startup(dev, SENSOR_CHAN_ALL);
+
+	edata = (struct icm42670_encoded_data *)buf;
+	edata->header.timestamp = k_ticks_to_ns_floor64(k_uptime_ticks());
+
+#if defined(CONFIG_ICM42670_TIMESTAMP) && defined(CONFIG_ICM42670_TRIGGER)
+	/* a data ready sample was taken when the interrupt fired */
+	uint64_t irq_ns = icm42670_irq_ns_get(data, false);
+
+	if ((events & ICM42670_EVENT_DATA_READY) && irq_ns) {
+		edata->header.timestamp = irq_ns;
+	}
+#endif
+	edata->header.accel_fs_sel = data->accel_fs_sel;
+	edata->header.gyro_fs_sel = data->gyro_fs_sel;
+	edata->header.config_gen = data->config_gen;
+	edata->header.is_fifo = 0;
+	edata->header.events = events;
+
+	/* temperature, accel and gyro registers are contiguous, read them in one burst */
+	res = icm42670_bus_read(cfg, REG_TEMP_DATA1, edata->readings,
+				sizeof(edata->readings));
+	icm42670_unlock(dev);
+
+	if (res) {
+		rtio_iodev_sqe_err(iodev_sqe, res);
+		return;
+	}
+
+	rtio_iodev_sqe_ok(iodev_sqe, 0);
+}
+
+static void icm42670_rtio_work_handler(struct k_work *work)
+{
+	struct icm42670_data *data = CONTAINER_OF(work, struct icm42670_data, rtio_work);
+	struct mpsc_node *node;
+
+	while ((node = mpsc_pop(&data->rtio_queue)) != NULL) {
+		struct rtio_iodev_sqe *iodev_sqe = CONTAINER_OF(node, struct rtio_iodev_sqe, q);
+		const struct sensor_read_config *read_cfg = iodev_sqe->sqe.iodev->data;
+
+		if (!read_cfg->is_streaming) {
+			icm42670_submit_one_shot(data->dev, iodev_sqe, 0);
+			continue;
+		}
+
+#ifdef CONFIG_ICM42670_STREAM
+		icm42670_submit_stream(data->dev, iodev_sqe);
+#else
+		rtio_iodev_sqe_err(iodev_sqe, -ENOTSUP);
+#endif
+	}
+}
+
+void icm42670_submit(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe)
+{
+	struct icm42670_data *data = dev->data;
+
+	if (!icm42670_is_ready(dev)) {
+		rtio_iodev_sqe_err(iodev_sqe, -EAGAIN);
+		return;
+	}
+
+	mpsc_push(&data->rtio_queue, &iodev_sqe->q);
+	k_work_submit(&data->rtio_work);
+}
+
+void icm42670_rtio_init(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+
+	mpsc_init(&data->rtio_queue);
+	k_work_init(&data->rtio_work, icm42670_rtio_work_handler);
+}
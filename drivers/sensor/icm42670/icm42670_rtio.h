@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_RTIO_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_RTIO_H_
+
+#include <zephyr/device.h>
+#include <zephyr/rtio/rtio.h>
+
+/** implement the submit sensor api function */
+void icm42670_submit(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe);
+
+/**
+ * @brief read the sensor data registers into the buffer of a request and complete it
+ *
+ * @param dev icm42670 device pointer
+ * @param iodev_sqe request to complete
+ * @param events ICM42670_EVENT_* flags to record in the encoded header
+ */
+void icm42670_submit_one_shot(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe,
+			      uint8_t events);
+
+#ifdef CONFIG_ICM42670_STREAM
+/**
+ * @brief arm a streaming request, completed by icm42670_stream_event()
+ *
+ * @param dev icm42670 device pointer
+ * @param iodev_sqe streaming request
+ */
+void icm42670_submit_stream(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe);
+
+/**
+ * @brief complete the pending streaming request after an interrupt, the
+ * caller must hold the driver lock
+ *
+ * @param dev icm42670 device pointer
+ * @param int_status REG_INT_STATUS value read by the interrupt handler
+ */
+void icm42670_stream_event(const struct device *dev, uint8_t int_status);
+#endif
+
+/**
+ * @brief initialize the icm42670 asynchronous read queue
+ *
+ * @param dev icm42670 device pointer
+ */
+void icm42670_rtio_init(const struct device *dev);
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_RTIO_H_ */
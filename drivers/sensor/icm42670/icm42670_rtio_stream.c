@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Streaming: the interrupt thread drains the FIFO (or reads the data
+ * registers on data ready) straight into the buffer of the pending
+ * sensor_stream() request and completes it, without a trigger handler.
+ */
+
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/sys/byteorder.h>
+#include "icm42670.h"
+#include "icm42670_decoder.h"
+#include "icm42670_fifo.h"
+#include "icm42670_reg.h"
+#include "icm42670_rtio.h"
+#include "icm42670_tmst.h"
+#include "icm42670_trigger.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ICM42670, CONFIG_SENSOR_LOG_LEVEL);
+
+#define ICM42670_FIFO_SOURCES (BIT_INT_FIFO_THS_INT1_EN | BIT_INT_FIFO_FULL_INT1_EN)
+
+void icm42670_submit_stream(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe)
+{
+	const struct sensor_read_config *read_cfg = iodev_sqe->sqe.iodev->data;
+	struct icm42670_data *data = dev->data;
+	enum sensor_stream_data_opt fifo_opt = SENSOR_STREAM_DATA_DROP;
+	enum sensor_stream_data_opt drdy_opt = SENSOR_STREAM_DATA_DROP;
+	uint8_t sources = 0;
+	int res = 0;
+
+	for (size_t i = 0; i < read_cfg->count; i++) {
+		const struct sensor_stream_trigger *trig = &read_cfg->triggers[i];
+
+		switch (trig->trigger) {
+		case SENSOR_TRIG_DATA_READY:
+			sources |= BIT_INT_DRDY_INT1_EN;
+			drdy_opt = MIN(drdy_opt, trig->opt);
+			break;
+		case SENSOR_TRIG_FIFO_WATERMARK:
+			sources |= BIT_INT_FIFO_THS_INT1_EN;
+			fifo_opt = MIN(fifo_opt, trig->opt);
+			break;
+		case SENSOR_TRIG_FIFO_FULL:
+			sources |= BIT_INT_FIFO_FULL_INT1_EN;
+			fifo_opt = MIN(fifo_opt, trig->opt);
+			break;
+		default:
+			LOG_ERR("Unsupported stream trigger %d", trig->trigger);
+			rtio_iodev_sqe_err(iodev_sqe, -ENOTSUP);
+			return;
+		}
+	}
+
+	icm42670_lock(dev);
+
+	data->stream_fifo_opt = fifo_opt;
+	data->stream_drdy_opt = drdy_opt;
+
+	/* resubmissions of a multishot stream keep the same triggers, skip the bus then */
+	if (sources != data->stream_sources) {
+		data->stream_sources = sources;
+
+		if (sources & ICM42670_FIFO_SOURCES) {
+			res = icm42670_fifo_claim(dev, ICM42670_FIFO_OWNER_STREAM);
+		} else {
+			res = icm42670_fifo_release(dev, ICM42670_FIFO_OWNER_STREAM);
+		}
+
+		if (!res) {
+			res = icm42670_trigger_update_sources(dev);
+		}
+	}
+
+	if (res) {
+		icm42670_unlock(dev);
+		rtio_iodev_sqe_err(iodev_sqe, res);
+		return;
+	}
+
+	data->streaming_sqe = iodev_sqe;
+
+	icm42670_unlock(dev);
+}
+
+/*
+ * the stream was cancelled, stop routing its interrupts and the FIFO it
+ * started, the caller holds the lock
+ */
+static void icm42670_stream_cancel(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	int res;
+
+	LOG_DBG("%s stream cancelled", dev->name);
+
+	data->streaming_sqe = NULL;
+	data->stream_sources = 0;
+
+	res = icm42670_fifo_release(dev, ICM42670_FIFO_OWNER_STREAM);
+
+	if (!res) {
+		res = icm42670_trigger_update_sources(dev);
+	}
+
+	if (res) {
+		LOG_ERR("Failed to release the stream FIFO and interrupts (%d)", res);
+	}
+}
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+/* stamp the frame with the host time of its newest packet and the measured period */
+static void icm42670_stream_timestamp(const struct device *dev, struct icm42670_fifo_data *fdata,
+				      size_t fifo_count, uint64_t read_ns)
+{
+	struct icm42670_data *data = dev->data;
+	const uint8_t *packets = fdata->packets;
+	size_t last = fdata->fifo_count - 1;
+	int64_t period = icm42670_tmst_period_ticks(dev);
+	uint64_t host_ns;
+	size_t anchor = icm42670_tmst_fifo_anchor(dev, fdata->fifo_count, fifo_count, read_ns,
+						  &host_ns);
+	uint16_t anchor_raw =
+		sys_get_be16(&packets[anchor * fdata->packet_size + ICM42670_FIFO_TMST_OFFSET]);
+	uint16_t last_raw =
+		sys_get_be16(&packets[last * fdata->packet_size + ICM42670_FIFO_TMST_OFFSET]);
+
+	icm42670_tmst_sync(&data->tmst, anchor_raw, host_ns);
+
+	fdata->header.timestamp = icm42670_tmst_to_ns(&data->tmst, last_raw,
+						      (int64_t)(last - anchor) * period);
+	fdata->sample_period_ns = (period * data->tmst.scale_q16) >> 16;
+}
+#endif
+
+static void icm42670_stream_fifo(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe,
+				 uint8_t events, enum sensor_stream_data_opt opt)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	const uint32_t min_buf_len = sizeof(struct icm42670_fifo_data);
+	struct icm42670_fifo_data *fdata;
+	uint8_t buffer[FIFO_COUNT_SIZE];
+	uint16_t count = 0;
+	uint32_t buf_len;
+	uint8_t *buf;
+	int res;
+
+	if (opt == SENSOR_STREAM_DATA_INCLUDE) {
+		res = icm42670_bus_read(cfg, REG_FIFO_COUNTH, buffer, FIFO_COUNT_SIZE);
+
+		if (res) {
+			rtio_iodev_sqe_err(iodev_sqe, res);
+			return;
+		}
+
+		count = sys_get_be16(buffer);
+	} else if (opt == SENSOR_STREAM_DATA_DROP && data->fifo_enabled) {
+		res = icm42670_bus_write(cfg, REG_SIGNAL_PATH_RESET, BIT_FIFO_FLUSH);
+
+		if (res) {
+			rtio_iodev_sqe_err(iodev_sqe, res);
+			return;
+		}
+	}
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+	uint64_t read_ns = k_cyc_to_ns_floor64(k_cycle_get_64());
+	size_t fifo_count = count;
+
+	/* only a drop empties the FIFO without a drain */
+	data->tmst_fifo_empty = (opt == SENSOR_STREAM_DATA_DROP);
+#endif
+
+	res = rtio_sqe_rx_buf(iodev_sqe, min_buf_len,
+			      min_buf_len + count * data->fifo_packet_size, &buf, &buf_len);
+
+	if (res) {
+		LOG_ERR("Failed to get a read buffer of size %u bytes", min_buf_len);
+		rtio_iodev_sqe_err(iodev_sqe, res);
+		return;
+	}
+
+	fdata = (struct icm42670_fifo_data *)buf;
+	fdata->header.timestamp = k_ticks_to_ns_floor64(k_uptime_ticks());
+	fdata->header.accel_fs_sel = data->accel_fs_sel;
+	fdata->header.gyro_fs_sel = data->gyro_fs_sel;
+	fdata->header.config_gen = data->config_gen;
+	fdata->header.is_fifo = 1;
+	fdata->header.events = events;
+	fdata->sample_period_ns = NSEC_PER_SEC / MAX(data->accel_hz, data->gyro_hz);
+	fdata->packet_size = data->fifo_packet_size;
+
+	if (count > 0) {
+		/* a smaller buffer than asked for just leaves the rest in the FIFO */
+		count = MIN(count, (buf_len - min_buf_len) / data->fifo_packet_size);
+	}
+
+	fdata->fifo_count = count;
+
+	if (count > 0) {
+		res = icm42670_bus_read(cfg, REG_FIFO_DATA, fdata->packets,
+					count * data->fifo_packet_size);
+
+		if (res) {
+			rtio_iodev_sqe_err(iodev_sqe, res);
+			return;
+		}
+
+#ifdef CONFIG_ICM42670_TIMESTAMP
+		icm42670_stream_timestamp(dev, fdata, fifo_count, read_ns);
+#endif
+	}
+
+	rtio_iodev_sqe_ok(iodev_sqe, 0);
+}
+
+void icm42670_stream_event(const struct device *dev, uint8_t int_status)
+{
+	const struct icm42670_config *cfg = dev->config;
+	struct icm42670_data *data = dev->data;
+	struct rtio_iodev_sqe *iodev_sqe = data->streaming_sqe;
+	uint8_t events = 0;
+
+	if (!iodev_sqe) {
+		return;
+	}
+
+	if (FIELD_GET(RTIO_SQE_CANCELED, iodev_sqe->sqe.flags)) {
+		icm42670_stream_cancel(dev);
+		return;
+	}
+
+	if ((data->stream_sources & BIT_INT_FIFO_THS_INT1_EN) &&
+	    FIELD_GET(BIT_INT_STATUS_FIFO_THS, int_status)) {
+		events |= ICM42670_EVENT_FIFO_THS;
+	}
+
+	if ((data->stream_sources & BIT_INT_FIFO_FULL_INT1_EN) &&
+	    FIELD_GET(BIT_INT_STATUS_FIFO_FULL, int_status)) {
+		events |= ICM42670_EVENT_FIFO_FULL;
+	}
+
+	if (data->stream_sources & BIT_INT_DRDY_INT1_EN) {
+		uint8_t status;
+
+		if (icm42670_bus_read(cfg, REG_INT_STATUS_DRDY, &status, 1) == 0 &&
+		    FIELD_GET(BIT_INT_STATUS_DATA_DRDY, status)) {
+			events |= ICM42670_EVENT_DATA_READY;
+		}
+	}
+
+	if (events == 0) {
+		return;
+	}
+
+	/* the completion may resubmit the stream, so release the request first */
+	data->streaming_sqe = NULL;
+
+	if (events & (ICM42670_EVENT_FIFO_THS | ICM42670_EVENT_FIFO_FULL)) {
+		icm42670_stream_fifo(dev, iodev_sqe, events, data->stream_fifo_opt);
+	} else if (data->stream_drdy_opt == SENSOR_STREAM_DATA_INCLUDE) {
+		icm42670_submit_one_shot(dev, iodev_sqe, events);
+	} else {
+		/* only report the event, an empty FIFO style frame carries no samples */
+		icm42670_stream_fifo(dev, iodev_sqe, events, SENSOR_STREAM_DATA_NOP);
+	}
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Shell commands for inspecting ICM42670 instances at runtime.
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/shell/shell.h>
+#include "icm42670.h"
+
+static const char *const icm42670_bus_class_names[] = {
+	[ICM42670_BUS_CLASS_DATA] = "data",
+	[ICM42670_BUS_CLASS_CONFIG] = "config",
+	[ICM42670_BUS_CLASS_MREG] = "mreg",
+};
+
+static const struct device *icm42670_shell_device(const struct shell *sh, const char *name)
+{
+	const struct device *dev = device_get_binding(name);
+
+	if (!dev || !icm42670_is_instance(dev)) {
+		shell_error(sh, "%s: not an icm42670 device", name);
+		return NULL;
+	}
+
+	return dev;
+}
+
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+	const struct device *dev = icm42670_shell_device(sh, argv[1]);
+	struct icm42670_bus_stats stats;
+
+	ARG_UNUSED(argc);
+
+	if (!dev) {
+		return -ENODEV;
+	}
+
+	icm42670_bus_stats_get(dev, &stats);
+
+	for (int i = 0; i < ICM42670_BUS_CLASS_COUNT; i++) {
+		const struct icm42670_bus_class_stats *cls = &stats.classes[i];
+
+		shell_print(sh, "%-6s %u transactions, %u bytes, %u errors, %u retries, %llu us",
+			    icm42670_bus_class_names[i], cls->transactions, cls->bytes, cls->errors,
+			    cls->retries, (unsigned long long)cls->busy_us);
+	}
+
+	shell_print(sh, "latency:");
+	shell_print(sh, "  < 16 us: %u", stats.latency_hist[0]);
+
+	for (int i = 1; i < ICM42670_BUS_HIST_BINS - 1; i++) {
+		shell_print(sh, "  < %u us: %u", 16U << i, stats.latency_hist[i]);
+	}
+
+	shell_print(sh, "  >= %u us: %u", 8U << (ICM42670_BUS_HIST_BINS - 1),
+		    stats.latency_hist[ICM42670_BUS_HIST_BINS - 1]);
+	shell_print(sh, "  max %u us", stats.max_latency_us);
+
+	return 0;
+}
+
+static int cmd_stats_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	const struct device *dev = icm42670_shell_device(sh, argv[1]);
+
+	ARG_UNUSED(argc);
+
+	if (!dev) {
+		return -ENODEV;
+	}
+
+	icm42670_bus_stats_reset(dev);
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_icm42670,
+	SHELL_CMD_ARG(stats, NULL, "Show bus statistics\nUsage: stats <device>", cmd_stats, 2, 0),
+	SHELL_CMD_ARG(stats_reset, NULL, "Clear bus statistics\nUsage: stats_reset <device>",
+		      cmd_stats_reset, 2, 0),
+	SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(icm42670, &sub_icm42670, "ICM42670 commands", NULL);
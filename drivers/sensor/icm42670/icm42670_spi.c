@@ -11,7 +11,8 @@
 #include "icm42670_reg.h"
 
 #if ICM42670_BUS_SPI
-static inline int spi_write_register(const union icm42670_bus *bus, uint8_t reg, uint8_t data)
+static inline int spi_write_registers(const union icm42670_bus *bus, uint8_t reg,
+				      const uint8_t *data, size_t len)
 {
 	const struct spi_buf buf[2] = {
 		{
@@ -19,8 +20,8 @@ static inline int spi_write_register(const union icm42670_bus *bus, uint8_t reg,
 			.len = 1,
 		},
 		{
-			.buf = &data,
-			.len = 1,
+			.buf = (uint8_t *)data,
+			.len = len,
 		}
 	};
 
@@ -32,6 +33,11 @@ static inline int spi_write_register(const union icm42670_bus *bus, uint8_t reg,
 	return spi_write_dt(&bus->spi, &tx);
 }
 
+static inline int spi_write_register(const union icm42670_bus *bus, uint8_t reg, uint8_t data)
+{
+	return spi_write_registers(bus, reg, &data, 1);
+}
+
 static inline int spi_read_register(const union icm42670_bus *bus, uint8_t reg, uint8_t *data,
 				    size_t len)
 {
@@ -69,7 +75,15 @@ static inline int spi_read_register(const union icm42670_bus *bus, uint8_t reg,
 static inline int spi_read_mreg(const union icm42670_bus *bus, uint8_t reg, uint8_t bank,
 				uint8_t *buf, size_t len)
 {
-	int res = spi_write_register(bus, REG_BLK_SEL_R, bank);
+	/* BLK_SEL_R and MADDR_R are contiguous, select bank and first address in one burst */
+	uint8_t sel[2] = { bank, reg };
+	int res;
+
+	if (len == 0) {
+		return 0;
+	}
+
+	res = spi_write_registers(bus, REG_BLK_SEL_R, sel, sizeof(sel));
 
 	if (res) {
 		return res;
@@ -77,49 +91,60 @@ static inline int spi_read_mreg(const union icm42670_bus *bus, uint8_t reg, uint
 
 	/* reads from MREG registers must be done byte-by-byte */
 	for (size_t i = 0; i < len; i++) {
-		uint8_t addr = reg + i;
+		if (i > 0) {
+			res = spi_write_register(bus, REG_MADDR_R, reg + i);
 
-		res = spi_write_register(bus, REG_MADDR_R, addr);
-
-		if (res) {
-			return res;
+			if (res) {
+				return res;
+			}
 		}
 
-		k_usleep(MREG_R_W_WAIT_US);
+		/* the wait is far below a tick, spin rather than yield */
+		k_busy_wait(MREG_R_W_WAIT_US);
 		res = spi_read_register(bus, REG_M_R, &buf[i], 1);
 
 		if (res) {
 			return res;
 		}
 
-		k_usleep(MREG_R_W_WAIT_US);
+		k_busy_wait(MREG_R_W_WAIT_US);
 	}
 
 	return 0;
 }
 
 static inline int spi_write_mreg(const union icm42670_bus *bus, uint8_t reg, uint8_t bank,
-				 uint8_t buf)
+				 const uint8_t *buf, size_t len)
 {
-	int res = spi_write_register(bus, REG_BLK_SEL_W, bank);
+	/* BLK_SEL_W, MADDR_W and M_W are contiguous, the first byte takes a single burst */
+	uint8_t first[3] = { bank, reg, 0 };
+	int res;
 
-	if (res) {
-		return res;
+	if (len == 0) {
+		return 0;
 	}
 
-	res = spi_write_register(bus, REG_MADDR_W, reg);
+	first[2] = buf[0];
+	res = spi_write_registers(bus, REG_BLK_SEL_W, first, sizeof(first));
 
 	if (res) {
 		return res;
 	}
 
-	res = spi_write_register(bus, REG_M_W, buf);
+	k_busy_wait(MREG_R_W_WAIT_US);
 
-	if (res) {
-		return res;
-	}
+	/* the bank stays selected, the following bytes only need MADDR_W and M_W */
+	for (size_t i = 1; i < len; i++) {
+		uint8_t next[2] = { reg + i, buf[i] };
+
+		res = spi_write_registers(bus, REG_MADDR_W, next, sizeof(next));
+
+		if (res) {
+			return res;
+		}
 
-	k_usleep(MREG_R_W_WAIT_US);
+		k_busy_wait(MREG_R_W_WAIT_US);
+	}
 
 	return 0;
 }
@@ -139,21 +164,27 @@ int icm42670_spi_read(const union icm42670_bus *bus, uint16_t reg, uint8_t *data
 	return res;
 }
 
-int icm42670_spi_single_write(const union icm42670_bus *bus, uint16_t reg, uint8_t data)
+int icm42670_spi_write(const union icm42670_bus *bus, uint16_t reg, const uint8_t *data,
+		       size_t len)
 {
 	int res = 0;
 	uint8_t bank = FIELD_GET(REG_BANK_MASK, reg);
 	uint8_t address = FIELD_GET(REG_ADDRESS_MASK, reg);
 
 	if (bank) {
-		res = spi_write_mreg(bus, address, bank, data);
+		res = spi_write_mreg(bus, address, bank, data, len);
 	} else {
-		res = spi_write_register(bus, address, data);
+		res = spi_write_registers(bus, address, data, len);
 	}
 
 	return res;
 }
 
+int icm42670_spi_single_write(const union icm42670_bus *bus, uint16_t reg, uint8_t data)
+{
+	return icm42670_spi_write(bus, reg, &data, 1);
+}
+
 int icm42670_spi_update_register(const union icm42670_bus *bus, uint16_t reg, uint8_t mask,
 				 uint8_t data)
 {
@@ -179,6 +210,7 @@ const struct icm42670_bus_io icm42670_bus_io_spi = {
 	.check = icm42670_bus_check_spi,
 	.read = icm42670_spi_read,
 	.write = icm42670_spi_single_write,
+	.write_block = icm42670_spi_write,
 	.update = icm42670_spi_update_register,
 };
 
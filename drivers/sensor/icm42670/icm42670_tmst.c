@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Hardware timestamps: every FIFO record carries the 16-bit chip time it was
+ * sampled at. Sync points pair a record with a host time (interrupt or drain
+ * time) and the chip ticks between sync points are compared against the host
+ * clock to correct for the drift of the chip oscillator.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include "icm42670.h"
+#include "icm42670_reg.h"
+#include "icm42670_tmst.h"
+
+#define TMST_NOMINAL_SCALE_Q16		(NSEC_PER_USEC << 16) /* 1 us per tick */
+#define TMST_MAX_DRIFT_Q16		(TMST_NOMINAL_SCALE_Q16 / 20) /* +/-5% */
+#define TMST_MIN_SPAN_NS		(100 * NSEC_PER_MSEC)
+/* beyond this gap the wrap count can no longer be told apart despite the drift */
+#define TMST_MAX_GAP_NS			(1 * NSEC_PER_SEC)
+#define TMST_FILTER_SHIFT		3
+
+void icm42670_tmst_init(struct icm42670_tmst *tmst)
+{
+	tmst->host_ns = 0;
+	tmst->scale_q16 = TMST_NOMINAL_SCALE_Q16;
+	tmst->span_ticks = 0;
+	tmst->span_ns = 0;
+	tmst->raw = 0;
+	tmst->valid = false;
+}
+
+void icm42670_tmst_sync(struct icm42670_tmst *tmst, uint16_t raw, uint64_t host_ns)
+{
+	int64_t gap_ns = (int64_t)(host_ns - tmst->host_ns);
+
+	if (!tmst->valid || (gap_ns <= 0) || (gap_ns > TMST_MAX_GAP_NS)) {
+		/* no usable reference, restart the drift measurement from here */
+		tmst->span_ticks = 0;
+		tmst->span_ns = 0;
+	} else {
+		int64_t hint = (gap_ns << 16) / tmst->scale_q16;
+
+		tmst->span_ticks += icm42670_tmst_delta(tmst->raw, raw, hint);
+		tmst->span_ns += gap_ns;
+	}
+
+	tmst->raw = raw;
+	tmst->host_ns = host_ns;
+	tmst->valid = true;
+
+	if ((tmst->span_ns < TMST_MIN_SPAN_NS) || (tmst->span_ticks <= 0)) {
+		return;
+	}
+
+	/* low-pass the measured rate, interrupt latency shows up as jitter */
+	int64_t measured = (tmst->span_ns << 16) / tmst->span_ticks;
+
+	measured = CLAMP(measured, TMST_NOMINAL_SCALE_Q16 - TMST_MAX_DRIFT_Q16,
+			 TMST_NOMINAL_SCALE_Q16 + TMST_MAX_DRIFT_Q16);
+	tmst->scale_q16 += (measured - (int64_t)tmst->scale_q16) / BIT(TMST_FILTER_SHIFT);
+	tmst->span_ticks = 0;
+	tmst->span_ns = 0;
+}
+
+uint64_t icm42670_tmst_to_ns(const struct icm42670_tmst *tmst, uint16_t raw, int64_t hint)
+{
+	int64_t ticks = icm42670_tmst_delta(tmst->raw, raw, hint);
+
+	return tmst->host_ns + ((ticks * tmst->scale_q16) >> 16);
+}
+
+uint32_t icm42670_tmst_period_ticks(const struct device *dev)
+{
+	const struct icm42670_data *data = dev->data;
+
+	return USEC_PER_SEC / MAX(MAX(data->accel_hz, data->gyro_hz), 1);
+}
+
+size_t icm42670_tmst_fifo_anchor(const struct device *dev, size_t count, size_t fifo_count,
+				 uint64_t read_ns, uint64_t *host_ns)
+{
+	struct icm42670_data *data = dev->data;
+	bool was_empty = data->tmst_fifo_empty;
+
+	/* the next drain can only trust the interrupt if this one empties the FIFO */
+	fifo_count = MAX(fifo_count, count);
+	data->tmst_fifo_empty = (count == fifo_count);
+
+#ifdef CONFIG_ICM42670_TRIGGER
+	uint64_t irq_ns = icm42670_irq_ns_get(data, true);
+
+	/* the watermark interrupt fired when record fifo_wm was written to an empty FIFO */
+	if (irq_ns && was_empty && (count >= data->fifo_wm) &&
+	    (data->int_sources & BIT_INT_FIFO_THS_INT1_EN) &&
+	    !(data->int_sources & BIT_INT_DRDY_INT1_EN)) {
+		*host_ns = irq_ns;
+		return data->fifo_wm - 1;
+	}
+#else
+	ARG_UNUSED(was_empty);
+#endif
+
+	/* the newest record in the FIFO was taken half a period before the read on average */
+	uint64_t period_ns = (uint64_t)icm42670_tmst_period_ticks(dev) * NSEC_PER_USEC;
+
+	*host_ns = read_ns - period_ns / 2 - (fifo_count - count) * period_ns;
+
+	return count - 1;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_SENSOR_ICM42670_TMST_H_
+#define ZEPHYR_DRIVERS_SENSOR_ICM42670_TMST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+/* mapping of the 16-bit on-chip timestamp (1 us ticks) onto the host clock */
+struct icm42670_tmst {
+	/* host time of the last sync point, in ns */
+	uint64_t host_ns;
+	/* host ns per chip tick in Q16.16, tracks the drift of the chip oscillator */
+	uint32_t scale_q16;
+	/* chip ticks and host ns accumulated since the last drift update */
+	int64_t span_ticks;
+	int64_t span_ns;
+	/* raw chip timestamp of the last sync point */
+	uint16_t raw;
+	bool valid;
+};
+
+/**
+ * @brief ticks between two raw chip timestamps
+ *
+ * The 16-bit counter wraps every 65.5ms, the wrap count is chosen so that
+ * the result is the closest to @p hint.
+ *
+ * @param from raw timestamp of the reference sample
+ * @param to raw timestamp of the sample of interest
+ * @param hint expected number of ticks from @p from to @p to
+ * @return int64_t number of ticks, negative if @p to is older than @p from
+ */
+static inline int64_t icm42670_tmst_delta(uint16_t from, uint16_t to, int64_t hint)
+{
+	int64_t d = (uint16_t)(to - from);
+
+	return d + ((hint - d + INT16_MAX + 1) >> 16) * (UINT16_MAX + 1);
+}
+
+/**
+ * @brief forget the clock mapping and start over with the nominal tick rate
+ *
+ * @param tmst clock mapping
+ */
+void icm42670_tmst_init(struct icm42670_tmst *tmst);
+
+/**
+ * @brief record that the sample stamped @p raw was taken at @p host_ns
+ *
+ * Moves the sync point and, once enough time has been observed, updates
+ * the drift estimate.
+ *
+ * @param tmst clock mapping
+ * @param raw raw chip timestamp of the sample
+ * @param host_ns host time of the sample
+ */
+void icm42670_tmst_sync(struct icm42670_tmst *tmst, uint16_t raw, uint64_t host_ns);
+
+/**
+ * @brief host time of a sample close to the last sync point
+ *
+ * @param tmst clock mapping
+ * @param raw raw chip timestamp of the sample
+ * @param hint expected number of ticks from the sync point to the sample
+ * @return uint64_t host time of the sample in ns
+ */
+uint64_t icm42670_tmst_to_ns(const struct icm42670_tmst *tmst, uint16_t raw, int64_t hint);
+
+/**
+ * @brief pick the sync point of a FIFO drain
+ *
+ * The FIFO watermark interrupt time is used when it is known to belong to
+ * a record of this drain, the drain time otherwise. The caller must hold
+ * the driver lock.
+ *
+ * @param dev icm42670 device pointer
+ * @param count number of records drained
+ * @param fifo_count number of records in the FIFO when it was drained
+ * @param read_ns host time at which the FIFO count was read
+ * @param host_ns host time of the returned record
+ * @return size_t index of the sync record within the drain
+ */
+size_t icm42670_tmst_fifo_anchor(const struct device *dev, size_t count, size_t fifo_count,
+				 uint64_t read_ns, uint64_t *host_ns);
+
+/**
+ * @brief expected chip ticks between two FIFO records
+ *
+ * @param dev icm42670 device pointer
+ * @return uint32_t nominal sample period in chip ticks
+ */
+uint32_t icm42670_tmst_period_ticks(const struct device *dev);
+
+#endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_TMST_H_ */
@@ -9,7 +9,13 @@
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/sys/util.h>
 #include "icm42670.h"
+#include "icm42670_apex.h"
+#include "icm42670_cache.h"
+#include "icm42670_consumer.h"
+#include "icm42670_fifo.h"
+#include "icm42670_policy.h"
 #include "icm42670_reg.h"
+#include "icm42670_rtio.h"
 #include "icm42670_trigger.h"
 
 #include <zephyr/logging/log.h>
@@ -23,6 +29,15 @@ static void icm42670_gpio_callback(const struct device *dev, struct gpio_callbac
 
 	struct icm42670_data *data = CONTAINER_OF(cb, struct icm42670_data, gpio_cb);
 
+#ifdef CONFIG_ICM42670_TIMESTAMP
+	/* the closest host time to the sample that raised the interrupt */
+	uint64_t irq_ns = k_cyc_to_ns_floor64(k_cycle_get_64());
+	k_spinlock_key_t key = k_spin_lock(&data->irq_lock);
+
+	data->irq_ns = irq_ns;
+	k_spin_unlock(&data->irq_lock, key);
+#endif
+
 #if defined(CONFIG_ICM42670_TRIGGER_OWN_THREAD)
 	k_sem_give(&data->gpio_sem);
 #elif defined(CONFIG_ICM42670_TRIGGER_GLOBAL_THREAD)
@@ -30,20 +45,151 @@ static void icm42670_gpio_callback(const struct device *dev, struct gpio_callbac
 #endif
 }
 
+#ifdef CONFIG_ICM42670_SKIP_DRDY_STATUS
+/* true if a source outside INT_SOURCE0 is routed to INT1 */
+static bool icm42670_event_listeners(const struct icm42670_data *data)
+{
+#ifdef CONFIG_ICM42670_APEX
+	for (int i = 0; i < ICM42670_APEX_EV_COUNT; i++) {
+		if (data->apex_handlers[i].handler) {
+			return true;
+		}
+	}
+#endif
+
+	return (data->motion_handler != NULL) || icm42670_policy_running(data);
+}
+#endif
+
 static void icm42670_thread_cb(const struct device *dev)
 {
 	struct icm42670_data *data = dev->data;
 	const struct icm42670_config *cfg = dev->config;
+	sensor_trigger_handler_t drdy_handler;
+	const struct sensor_trigger *drdy_trigger;
 
 	icm42670_lock(dev);
 	gpio_pin_interrupt_configure_dt(&cfg->gpio_int, GPIO_INT_DISABLE);
 
-	if (data->data_ready_handler) {
-		data->data_ready_handler(dev, data->data_ready_trigger);
+#ifdef CONFIG_ICM42670_FIFO
+	sensor_trigger_handler_t full_handler = NULL;
+	sensor_trigger_handler_t wm_handler = NULL;
+	const struct sensor_trigger *full_trigger = data->fifo_full_trigger;
+	const struct sensor_trigger *wm_trigger = data->fifo_wm_trigger;
+	bool fifo_listeners = data->fifo_wm_handler || data->fifo_full_handler;
+	uint8_t status = 0;
+
+#ifdef CONFIG_ICM42670_STREAM
+	fifo_listeners |= data->stream_sources &
+			  (BIT_INT_FIFO_THS_INT1_EN | BIT_INT_FIFO_FULL_INT1_EN);
+#endif
+#ifdef CONFIG_ICM42670_CONSUMERS
+	fifo_listeners |= !sys_slist_is_empty(&data->consumers);
+#endif
+
+	/* reading INT_STATUS clears the FIFO interrupt flags, so do it only once */
+	if (fifo_listeners && icm42670_bus_read(cfg, REG_INT_STATUS, &status, 1) == 0) {
+		if (FIELD_GET(BIT_INT_STATUS_FIFO_FULL, status)) {
+			full_handler = data->fifo_full_handler;
+		}
+
+		if (FIELD_GET(BIT_INT_STATUS_FIFO_THS, status)) {
+			wm_handler = data->fifo_wm_handler;
+		}
 	}
 
-	gpio_pin_interrupt_configure_dt(&cfg->gpio_int, GPIO_INT_EDGE_TO_ACTIVE);
+#ifdef CONFIG_ICM42670_STREAM
+	icm42670_stream_event(dev, status);
+#endif
+#endif
+
+	sensor_trigger_handler_t motion_handler = NULL;
+	const struct sensor_trigger *motion_trigger = data->motion_trigger;
+	bool status2_listeners = (data->motion_handler != NULL) || icm42670_policy_running(data);
+	uint8_t status2 = 0;
+
+#ifdef CONFIG_ICM42670_APEX
+	struct icm42670_apex_handler apex_fired[ICM42670_APEX_EV_COUNT];
+
+	status2_listeners |= data->apex_handlers[ICM42670_APEX_EV_SMD].handler != NULL;
+#endif
+
+	/* reading INT_STATUS2 clears the wake on motion and significant motion flags */
+	if (status2_listeners && icm42670_bus_read(cfg, REG_INT_STATUS2, &status2, 1)) {
+		status2 = 0;
+	}
+
+	if (status2 & MASK_INT_STATUS_WOM) {
+		motion_handler = data->motion_handler;
+#ifdef CONFIG_ICM42670_MOTION_POLICY
+		icm42670_policy_motion(dev);
+#endif
+	}
+
+#ifdef CONFIG_ICM42670_APEX
+	icm42670_apex_events(dev, status2, apex_fired);
+#endif
+
+	drdy_handler = data->data_ready_handler;
+	drdy_trigger = data->data_ready_trigger;
+
+#ifdef CONFIG_ICM42670_FETCH_WAIT
+	/* the waiting fetch reads the data ready status itself */
+	if (data->drdy_waiters) {
+		k_sem_give(&data->drdy_sem);
+	}
+#endif
+
+#ifdef CONFIG_ICM42670_SKIP_DRDY_STATUS
+	/* INT1 can only mean data ready when no other source is routed to it */
+	atomic_set(&data->drdy_latched,
+		   drdy_handler && (data->int_sources == BIT_INT_DRDY_INT1_EN) &&
+		   !icm42670_event_listeners(data));
+#endif
+
+	/*
+	 * Handlers run without the driver lock, so a slow handler does not hold
+	 * up attribute changes or other users of the device.
+	 */
 	icm42670_unlock(dev);
+
+#ifdef CONFIG_ICM42670_CONSUMERS
+	if (status & (BIT_INT_STATUS_FIFO_THS | BIT_INT_STATUS_FIFO_FULL)) {
+		icm42670_consumer_drain(dev);
+	}
+#endif
+
+#ifdef CONFIG_ICM42670_FIFO
+	if (full_handler) {
+		full_handler(dev, full_trigger);
+	}
+
+	if (wm_handler) {
+		wm_handler(dev, wm_trigger);
+	}
+#endif
+
+	if (motion_handler) {
+		motion_handler(dev, motion_trigger);
+	}
+
+#ifdef CONFIG_ICM42670_APEX
+	for (int i = 0; i < ICM42670_APEX_EV_COUNT; i++) {
+		if (apex_fired[i].handler) {
+			apex_fired[i].handler(dev, apex_fired[i].trigger);
+		}
+	}
+#endif
+
+	if (drdy_handler) {
+		drdy_handler(dev, drdy_trigger);
+	}
+
+#ifdef CONFIG_ICM42670_SKIP_DRDY_STATUS
+	atomic_clear(&data->drdy_latched);
+#endif
+
+	gpio_pin_interrupt_configure_dt(&cfg->gpio_int, GPIO_INT_EDGE_TO_ACTIVE);
 }
 
 #if defined(CONFIG_ICM42670_TRIGGER_OWN_THREAD)
@@ -72,6 +218,191 @@ static void icm42670_work_handler(struct k_work *work)
 
 #endif
 
+/* wake on motion interrupts, for the motion trigger or to leave the idle profile */
+static bool icm42670_wom_routed(const struct icm42670_data *data)
+{
+	if (data->motion_handler) {
+		return true;
+	}
+
+#ifdef CONFIG_ICM42670_MOTION_POLICY
+	return data->policy_running && (data->profile == ICM42670_PROFILE_IDLE);
+#else
+	return false;
+#endif
+}
+
+int icm42670_trigger_update_sources(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	uint8_t value = 0;
+	int res;
+
+	/* only route the interrupts someone listens to, so idle wakeups stay minimal */
+	if (data->data_ready_handler) {
+		value |= BIT_INT_DRDY_INT1_EN;
+	}
+
+#ifdef CONFIG_ICM42670_FETCH_WAIT
+	if (data->drdy_wait_routed) {
+		value |= BIT_INT_DRDY_INT1_EN;
+	}
+#endif
+
+#ifdef CONFIG_ICM42670_STREAM
+	value |= data->stream_sources;
+#endif
+
+#ifdef CONFIG_ICM42670_FIFO
+	if (data->fifo_wm_handler) {
+		value |= BIT_INT_FIFO_THS_INT1_EN;
+	}
+
+	if (data->fifo_full_handler) {
+		value |= BIT_INT_FIFO_FULL_INT1_EN;
+	}
+#endif
+
+#ifdef CONFIG_ICM42670_CONSUMERS
+	if (!sys_slist_is_empty(&data->consumers)) {
+		value |= BIT_INT_FIFO_THS_INT1_EN;
+	}
+#endif
+
+	res = icm42670_reg_write(dev, REG_INT_SOURCE0, value);
+
+	if (res) {
+		return res;
+	}
+
+	data->int_sources = value;
+
+	/* wake on motion has its own source register, any axis wakes the host */
+	value = icm42670_wom_routed(data) ? MASK_INT_WOM_INT1_EN : 0;
+
+#ifdef CONFIG_ICM42670_APEX
+	if (data->apex_handlers[ICM42670_APEX_EV_SMD].handler) {
+		value |= BIT_INT_SMD_INT1_EN;
+	}
+
+	res = icm42670_reg_write(dev, REG_INT_SOURCE1, value);
+
+	if (res) {
+		return res;
+	}
+
+	/* the other APEX events are routed through the MREG1 source register */
+	return icm42670_reg_write(dev, REG_INT_SOURCE6, icm42670_apex_int_sources(data));
+#else
+	return icm42670_reg_write(dev, REG_INT_SOURCE1, value);
+#endif
+}
+
+/* true if the wake on motion comparison has to run */
+static bool icm42670_wom_enabled(const struct icm42670_data *data)
+{
+	return (data->motion_handler != NULL) || icm42670_policy_running(data);
+}
+
+int icm42670_trigger_wom_config(const struct device *dev)
+{
+	struct icm42670_data *data = dev->data;
+	uint8_t value = 0;
+	int res;
+
+	if (icm42670_wom_enabled(data)) {
+		/* the thresholds must be in place before the comparison starts */
+		res = icm42670_reg_write_block(dev, REG_ACCEL_WOM_X_THR, data->wom_thr,
+					       sizeof(data->wom_thr));
+
+		if (res) {
+			return res;
+		}
+
+		/*
+		 * compare each sample with the previous one, any axis above its
+		 * threshold counts. The motion policy compares with the first sample
+		 * after arming instead, slow movement is then seen at any rate.
+		 */
+		value = BIT_WOM_EN | FIELD_PREP(MASK_WOM_INT_DUR, data->wom_dur);
+
+		if (!icm42670_policy_running(data)) {
+			value |= BIT_WOM_MODE;
+		}
+	}
+
+	res = icm42670_reg_write(dev, REG_WOM_CONFIG, value);
+
+	if (res) {
+		return res;
+	}
+
+	/* with a motion trigger installed the automatic power mode drops to LP */
+	return icm42670_update_accel_power(dev);
+}
+
+int icm42670_trigger_set_wom_threshold(const struct device *dev, enum sensor_channel chan,
+				       const struct sensor_value *val)
+{
+	struct icm42670_data *data = dev->data;
+	int64_t micro = sensor_value_to_micro(val);
+	uint8_t thr;
+
+	if (micro < 0) {
+		return -EINVAL;
+	}
+
+	/* round to the nearest 1g/256 step, 0 would fire on every sample */
+	thr = CLAMP((micro * WOM_THR_PER_G + SENSOR_G / 2) / SENSOR_G, 1, UINT8_MAX);
+
+	switch (chan) {
+	case SENSOR_CHAN_ACCEL_X:
+	case SENSOR_CHAN_ACCEL_Y:
+	case SENSOR_CHAN_ACCEL_Z:
+		data->wom_thr[chan - SENSOR_CHAN_ACCEL_X] = thr;
+		break;
+	case SENSOR_CHAN_ACCEL_XYZ:
+		memset(data->wom_thr, thr, sizeof(data->wom_thr));
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	if (!icm42670_wom_enabled(data)) {
+		return 0;
+	}
+
+	return icm42670_reg_write_block(dev, REG_ACCEL_WOM_X_THR, data->wom_thr,
+					sizeof(data->wom_thr));
+}
+
+void icm42670_trigger_get_wom_threshold(const struct device *dev, enum sensor_channel chan,
+					struct sensor_value *val)
+{
+	const struct icm42670_data *data = dev->data;
+	/* XYZ reports the X threshold, which is the common one if set through XYZ */
+	int idx = (chan == SENSOR_CHAN_ACCEL_XYZ) ? 0 : chan - SENSOR_CHAN_ACCEL_X;
+
+	sensor_value_from_micro(val, ((int64_t)data->wom_thr[idx] * SENSOR_G) / WOM_THR_PER_G);
+}
+
+int icm42670_trigger_set_wom_duration(const struct device *dev, const struct sensor_value *val)
+{
+	struct icm42670_data *data = dev->data;
+
+	if ((val->val1 < 1) || (val->val1 > MAX_WOM_DUR)) {
+		return -EINVAL;
+	}
+
+	data->wom_dur = val->val1 - 1;
+
+	if (!icm42670_wom_enabled(data)) {
+		return 0;
+	}
+
+	return icm42670_reg_update(dev, REG_WOM_CONFIG, (uint8_t)MASK_WOM_INT_DUR, data->wom_dur);
+}
+
 int icm42670_trigger_set(const struct device *dev, const struct sensor_trigger *trig,
 			 sensor_trigger_handler_t handler)
 {
@@ -79,8 +410,8 @@ int icm42670_trigger_set(const struct device *dev, const struct sensor_trigger *
 	struct icm42670_data *data = dev->data;
 	const struct icm42670_config *cfg = dev->config;
 
-	if (!handler) {
-		return -EINVAL;
+	if (!icm42670_is_ready(dev)) {
+		return -EAGAIN;
 	}
 
 	icm42670_lock(dev);
@@ -91,11 +422,53 @@ int icm42670_trigger_set(const struct device *dev, const struct sensor_trigger *
 		data->data_ready_handler = handler;
 		data->data_ready_trigger = trig;
 		break;
+	case SENSOR_TRIG_MOTION:
+		/* the motion policy owns the wake on motion configuration */
+		if (icm42670_policy_running(data)) {
+			res = -EBUSY;
+			break;
+		}
+
+		data->motion_handler = handler;
+		data->motion_trigger = trig;
+		res = icm42670_trigger_wom_config(dev);
+		break;
+#ifdef CONFIG_ICM42670_FIFO
+	case SENSOR_TRIG_FIFO_WATERMARK:
+		data->fifo_wm_handler = handler;
+		data->fifo_wm_trigger = trig;
+		break;
+	case SENSOR_TRIG_FIFO_FULL:
+		data->fifo_full_handler = handler;
+		data->fifo_full_trigger = trig;
+		break;
+#endif
 	default:
+#ifdef CONFIG_ICM42670_APEX
+		/* step, tilt, significant motion and freefall come from the APEX engine */
+		res = icm42670_apex_trigger_set(dev, trig, handler);
+#else
 		res = -ENOTSUP;
+#endif
 		break;
 	}
 
+#ifdef CONFIG_ICM42670_FIFO
+	/* FIFO triggers need samples buffered, the FIFO stops again with the last handler */
+	if (!res &&
+	    (trig->type == SENSOR_TRIG_FIFO_WATERMARK || trig->type == SENSOR_TRIG_FIFO_FULL)) {
+		if (data->fifo_wm_handler || data->fifo_full_handler) {
+			res = icm42670_fifo_claim(dev, ICM42670_FIFO_OWNER_TRIGGER);
+		} else {
+			res = icm42670_fifo_release(dev, ICM42670_FIFO_OWNER_TRIGGER);
+		}
+	}
+#endif
+
+	if (!res) {
+		res = icm42670_trigger_update_sources(dev);
+	}
+
 	icm42670_unlock(dev);
 	gpio_pin_interrupt_configure_dt(&cfg->gpio_int, GPIO_INT_EDGE_TO_ACTIVE);
 
@@ -118,7 +491,6 @@ int icm42670_trigger_init(const struct device *dev)
 		return -ENODEV;
 	}
 
-	data->dev = dev;
 	gpio_pin_configure_dt(&cfg->gpio_int, GPIO_INPUT);
 	gpio_init_callback(&data->gpio_cb, icm42670_gpio_callback, BIT(cfg->gpio_int.pin));
 	res = gpio_add_callback(cfg->gpio_int.port, &data->gpio_cb);
@@ -128,7 +500,17 @@ int icm42670_trigger_init(const struct device *dev)
 		return res;
 	}
 
-	k_mutex_init(&data->mutex);
+#ifdef CONFIG_ICM42670_FETCH_WAIT
+	k_sem_init(&data->drdy_sem, 0, 1);
+#endif
+
+#ifdef CONFIG_ICM42670_CONSUMERS
+	sys_slist_init(&data->consumers);
+#endif
+
+#ifdef CONFIG_ICM42670_MOTION_POLICY
+	icm42670_policy_init(dev);
+#endif
 
 #if defined(CONFIG_ICM42670_TRIGGER_OWN_THREAD)
 	k_sem_init(&data->gpio_sem, 0, K_SEM_MAX_LIMIT);
@@ -145,30 +527,25 @@ int icm42670_trigger_init(const struct device *dev)
 int icm42670_trigger_enable_interrupt(const struct device *dev)
 {
 	int res;
-	const struct icm42670_config *cfg = dev->config;
 
 	/* pulse-mode (auto clearing), push-pull and active-high */
-	res = cfg->bus_io->write(&cfg->bus, REG_INT_CONFIG,
+	res = icm42670_reg_write(dev, REG_INT_CONFIG,
 					BIT_INT1_DRIVE_CIRCUIT | BIT_INT1_POLARITY);
 
 	if (res) {
 		return res;
 	}
 
-	/* enable data ready interrupt on INT1 pin */
-	return cfg->bus_io->write(&cfg->bus, REG_INT_SOURCE0, BIT_INT_DRDY_INT1_EN);
-}
+#ifdef CONFIG_ICM42670_SKIP_DRDY_STATUS
+	/* fetches skip the status read, so let the data read clear the data ready flag */
+	res = icm42670_reg_write(dev, REG_INT_CONFIG0,
+				 FIELD_PREP(MASK_DRDY_INT_CLEAR, BIT_DRDY_INT_CLEAR_BOTH));
 
-void icm42670_lock(const struct device *dev)
-{
-	struct icm42670_data *data = dev->data;
-
-	k_mutex_lock(&data->mutex, K_FOREVER);
-}
-
-void icm42670_unlock(const struct device *dev)
-{
-	struct icm42670_data *data = dev->data;
+	if (res) {
+		return res;
+	}
+#endif
 
-	k_mutex_unlock(&data->mutex);
+	/* enable the interrupts of the installed triggers on INT1 pin */
+	return icm42670_trigger_update_sources(dev);
 }
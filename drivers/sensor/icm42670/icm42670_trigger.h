@@ -8,6 +8,7 @@
 #define ZEPHYR_DRIVERS_SENSOR_ICM42670_TRIGGER_H_
 
 #include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
 
 /** implement the trigger_set sensor api function */
 int icm42670_trigger_set(const struct device *dev, const struct sensor_trigger *trig,
@@ -30,17 +31,50 @@ int icm42670_trigger_init(const struct device *dev);
 int icm42670_trigger_enable_interrupt(const struct device *dev);
 
 /**
- * @brief lock access to the icm42670 device driver
+ * @brief route the interrupts of all installed triggers and streams to INT1
  *
  * @param dev icm42670 device pointer
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_trigger_update_sources(const struct device *dev);
+
+/**
+ * @brief set the wake on motion threshold of one or all accel axes
+ *
+ * @param dev icm42670 device pointer
+ * @param chan accel axis channel, or SENSOR_CHAN_ACCEL_XYZ for all axes
+ * @param val threshold in m/s^2
+ * @return int 0 on success, negative error code otherwise
  */
-void icm42670_lock(const struct device *dev);
+int icm42670_trigger_set_wom_threshold(const struct device *dev, enum sensor_channel chan,
+				       const struct sensor_value *val);
 
 /**
- * @brief lock access to the icm42670 device driver
+ * @brief get the wake on motion threshold of an accel axis
  *
  * @param dev icm42670 device pointer
+ * @param chan accel axis channel, SENSOR_CHAN_ACCEL_XYZ reports X
+ * @param val threshold in m/s^2
+ */
+void icm42670_trigger_get_wom_threshold(const struct device *dev, enum sensor_channel chan,
+					struct sensor_value *val);
+
+/**
+ * @brief program the wake on motion comparison for the motion trigger or the
+ *	  motion policy, or turn it off when neither needs it
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_trigger_wom_config(const struct device *dev);
+
+/**
+ * @brief set the number of samples above the threshold that raise a motion event
+ *
+ * @param dev icm42670 device pointer
+ * @param val number of samples, 1 to 4
+ * @return int 0 on success, negative error code otherwise
  */
-void icm42670_unlock(const struct device *dev);
+int icm42670_trigger_set_wom_duration(const struct device *dev, const struct sensor_value *val);
 
 #endif /* ZEPHYR_DRIVERS_SENSOR_ICM42670_TRIGGER_H_ */
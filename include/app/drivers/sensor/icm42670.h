@@ -0,0 +1,585 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Extended public API for the ICM42670 driver
+ *
+ * Functionality that does not fit the generic sensor API, such as draining
+ * the on-chip FIFO into a batch of frames.
+ */
+
+#ifndef ZEPHYR_INCLUDE_APP_DRIVERS_SENSOR_ICM42670_H_
+#define ZEPHYR_INCLUDE_APP_DRIVERS_SENSOR_ICM42670_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/slist.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief driver specific sensor attributes */
+enum icm42670_sensor_attribute {
+	/**
+	 * accel power mode, one of enum icm42670_accel_power_mode. Reading it
+	 * back reports the mode in effect, ICM42670_ACCEL_POWER_LN or _LP.
+	 */
+	ICM42670_ATTR_ACCEL_POWER_MODE = SENSOR_ATTR_PRIV_START,
+};
+
+/** @brief driver specific sensor channels, fetched from the APEX engine */
+enum icm42670_sensor_channel {
+	/** steps counted by the pedometer, wraps at 65535 */
+	ICM42670_CHAN_STEP_COUNT = SENSOR_CHAN_PRIV_START,
+	/** activity seen by the pedometer, one of enum icm42670_activity */
+	ICM42670_CHAN_ACTIVITY,
+};
+
+/**
+ * @brief driver specific triggers
+ *
+ * Tilt and freefall use SENSOR_TRIG_TILT and SENSOR_TRIG_FREEFALL.
+ */
+enum icm42670_sensor_trigger {
+	/** the pedometer detected a step */
+	ICM42670_TRIG_STEP = SENSOR_TRIG_PRIV_START,
+	/** significant motion, a few seconds of walking or similar movement */
+	ICM42670_TRIG_SIG_MOTION,
+};
+
+/**
+ * @brief APEX engine features, for SENSOR_ATTR_FEATURE_MASK on SENSOR_CHAN_ALL
+ *
+ * Installing an APEX trigger enables its feature as well, the attribute is
+ * for features that are only polled. Reading the attribute back reports all
+ * features running.
+ */
+enum icm42670_apex_feature {
+	ICM42670_APEX_PEDOMETER = BIT(0),
+	ICM42670_APEX_TILT = BIT(1),
+	/** significant motion detection, runs the pedometer as well */
+	ICM42670_APEX_SMD = BIT(2),
+	ICM42670_APEX_FREEFALL = BIT(3),
+};
+
+#define ICM42670_APEX_ALL                                                                          \
+	(ICM42670_APEX_PEDOMETER | ICM42670_APEX_TILT | ICM42670_APEX_SMD | ICM42670_APEX_FREEFALL)
+
+/** @brief activity classes reported by the pedometer */
+enum icm42670_activity {
+	ICM42670_ACTIVITY_UNKNOWN,
+	ICM42670_ACTIVITY_WALK,
+	ICM42670_ACTIVITY_RUN,
+};
+
+/**
+ * @brief accel power modes
+ *
+ * The low power mode duty-cycles the accelerometer and averages
+ * SENSOR_ATTR_OVERSAMPLING samples per output, which sets its noise level.
+ */
+enum icm42670_accel_power_mode {
+	/** low power whenever the sampling rate and averaging allow it */
+	ICM42670_ACCEL_POWER_AUTO,
+	/** always low noise */
+	ICM42670_ACCEL_POWER_LN,
+	/** always low power, up to 400 Hz */
+	ICM42670_ACCEL_POWER_LP,
+};
+
+/**
+ * @brief one sample parsed from a FIFO packet
+ *
+ * Values are raw sensor counts at the full scale active when the sample was
+ * taken, or at +-16g and +-2000dps for high resolution packets. The
+ * temperature is rescaled to the TEMP_DATA register format so it converts
+ * the same way as a register read.
+ */
+struct icm42670_fifo_frame {
+	/**
+	 * sample time in ns on the k_cycle_get_64() time base, derived from the
+	 * chip timestamp, 0 without CONFIG_ICM42670_TIMESTAMP
+	 */
+	uint64_t timestamp_ns;
+	int16_t accel[3];
+	int16_t gyro[3];
+	int16_t temp;
+	/** raw 16-bit chip timestamp in 1 us ticks, 0 if the packet has none */
+	uint16_t tmst;
+	/** raw FIFO packet header byte */
+	uint8_t header;
+	/** configuration generation the sample was taken with, see icm42670_config_gen() */
+	uint16_t config_gen;
+	/** conversion constants of the accel and gyro fields */
+	const struct icm42670_scale *accel_scale;
+	const struct icm42670_scale *gyro_scale;
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+	/** MSB aligned 20-bit accel counts at 2^15 LSB/g, see icm42670_get_hires_scale() */
+	int32_t accel_hires[3];
+	/** MSB aligned 20-bit gyro counts at 262.144 LSB/dps, see icm42670_get_hires_scale() */
+	int32_t gyro_hires[3];
+#endif
+};
+
+/**
+ * @brief constants converting raw counts of one channel to SI units
+ *
+ * Precomputed for every full scale so a conversion is a multiply and a
+ * shift: micro = ((raw * micro_mult) >> micro_shift) + micro_offset and
+ * q31 = ((raw * q31_mult) >> 16) + q31_offset, where the q31 value has
+ * q31_shift integer bits as in struct sensor_q31_data.
+ */
+struct icm42670_scale {
+	uint32_t micro_mult;
+	int32_t micro_offset;
+	uint32_t q31_mult;
+	int32_t q31_offset;
+	uint8_t micro_shift;
+	int8_t q31_shift;
+};
+
+/**
+ * @brief get the conversion constants of the currently configured full scale
+ *
+ * The constants change when the full scale is reconfigured, samples must be
+ * converted with the scale they were taken at.
+ *
+ * @param dev icm42670 device pointer
+ * @param chan accel, gyro or die temperature channel
+ * @param scale destination for the constants
+ * @return int 0 on success, -ENOTSUP for other channels
+ */
+int icm42670_get_scale(const struct device *dev, enum sensor_channel chan,
+		       struct icm42670_scale *scale);
+
+/**
+ * @brief convert a batch of raw counts to sensor values
+ *
+ * Axis triplets are converted by passing 3 * number of samples as @p n.
+ *
+ * @param scale constants from icm42670_get_scale()
+ * @param raw raw counts
+ * @param val destination array
+ * @param n number of values
+ */
+void icm42670_convert_to_values(const struct icm42670_scale *scale, const int16_t *raw,
+				struct sensor_value *val, size_t n);
+
+/**
+ * @brief convert a batch of raw counts to micro SI units
+ *
+ * @param scale constants from icm42670_get_scale()
+ * @param raw raw counts
+ * @param micro destination array
+ * @param n number of values
+ */
+void icm42670_convert_to_micro(const struct icm42670_scale *scale, const int16_t *raw,
+			       int32_t *micro, size_t n);
+
+/**
+ * @brief convert a batch of raw counts to q31 values
+ *
+ * @param scale constants from icm42670_get_scale(), the q31 values have
+ *	  scale->q31_shift integer bits
+ * @param raw raw counts
+ * @param out destination array
+ * @param n number of values
+ */
+void icm42670_convert_to_q31(const struct icm42670_scale *scale, const int16_t *raw, q31_t *out,
+			     size_t n);
+
+/**
+ * @brief get the conversion constants of 20-bit high resolution FIFO values
+ *
+ * Only available with CONFIG_ICM42670_FIFO_HIRES.
+ *
+ * @param chan accel or gyro channel
+ * @param scale destination for the constants
+ * @return int 0 on success, -ENOTSUP for other channels
+ */
+int icm42670_get_hires_scale(enum sensor_channel chan, struct icm42670_scale *scale);
+
+/**
+ * @brief convert a batch of 20-bit high resolution counts to q31 values
+ *
+ * Only available with CONFIG_ICM42670_FIFO_HIRES.
+ *
+ * @param scale constants from icm42670_get_hires_scale()
+ * @param raw accel_hires or gyro_hires values of FIFO frames
+ * @param out destination array
+ * @param n number of values
+ */
+void icm42670_convert_hires_to_q31(const struct icm42670_scale *scale, const int32_t *raw,
+				   q31_t *out, size_t n);
+
+/**
+ * @brief latest sample in raw sensor counts, with the scale it was taken at
+ */
+struct icm42670_raw_sample {
+	/** time the sample was read from the sensor, in ns since boot */
+	uint64_t timestamp_ns;
+	int16_t accel[3];
+	int16_t gyro[3];
+	int16_t temp;
+	struct icm42670_scale accel_scale;
+	struct icm42670_scale gyro_scale;
+	struct icm42670_scale temp_scale;
+	/** configuration generation the sample was taken with, see icm42670_config_gen() */
+	uint16_t config_gen;
+};
+
+/**
+ * @brief get the latest fetched sample without converting it
+ *
+ * Replaces one sensor_channel_get() per channel with a single consistent
+ * snapshot. It never waits for a fetch in progress.
+ *
+ * @param dev icm42670 device pointer
+ * @param raw destination for the sample
+ * @return int 0 on success, -ENODATA if nothing was fetched yet
+ */
+int icm42670_get_raw(const struct device *dev, struct icm42670_raw_sample *raw);
+
+/**
+ * @brief fetch all channels and return them without converting them
+ *
+ * Equivalent to sensor_sample_fetch() followed by icm42670_get_raw().
+ *
+ * @param dev icm42670 device pointer
+ * @param raw destination for the sample
+ * @return int 0 on success, negative error code from the fetch otherwise
+ */
+int icm42670_fetch_raw(const struct device *dev, struct icm42670_raw_sample *raw);
+
+/**
+ * @brief get the current configuration generation
+ *
+ * The generation is bumped whenever a sampling rate or full scale changes.
+ * The FIFO is flushed at the same time and register reads wait for a sample
+ * taken with the new settings, so every delivered sample carries the
+ * generation, and scale, it was really taken with and a batch never mixes
+ * two of them. It wraps at 65535.
+ *
+ * @param dev icm42670 device pointer
+ * @return uint16_t configuration generation
+ */
+uint16_t icm42670_config_gen(const struct device *dev);
+
+/**
+ * @brief get the configuration generation of a buffer from the read and
+ *	  stream API
+ *
+ * Only available with CONFIG_SENSOR_ASYNC_API.
+ *
+ * @param buffer encoded buffer
+ * @return uint16_t configuration generation of all samples in the buffer
+ */
+uint16_t icm42670_encoded_config_gen(const uint8_t *buffer);
+
+/**
+ * @brief wait until the sensor has finished powering up
+ *
+ * With CONFIG_ICM42670_DEFERRED_INIT the power-up sequence runs in the
+ * background after boot and the sensor API returns -EAGAIN until it is done.
+ * Without it the device is ready as soon as it is, and this returns at once.
+ *
+ * @param dev icm42670 device pointer
+ * @param timeout maximum time to wait
+ * @return int 0 when ready, -EAGAIN on timeout, -EIO if the power-up failed
+ */
+int icm42670_wait_ready(const struct device *dev, k_timeout_t timeout);
+
+/**
+ * @brief put the gyro in standby between bursts of samples, or wake it up
+ *
+ * Standby keeps the gyro drive running, so waking up takes a few ms instead
+ * of the full start-up time from off. Fetches issued before the gyro has
+ * settled wait for the remaining time.
+ *
+ * @param dev icm42670 device pointer
+ * @param standby true to enter standby, false to resume sampling
+ * @return int 0 on success, -EIO while the device is suspended, negative
+ *	   error code otherwise
+ */
+int icm42670_gyro_standby(const struct device *dev, bool standby);
+
+/**
+ * @brief start buffering accel and gyro samples in the FIFO
+ *
+ * The FIFO is flushed, so only samples taken after this call are returned
+ * by icm42670_fifo_read().
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_fifo_start(const struct device *dev);
+
+/**
+ * @brief stop buffering samples and put the FIFO back in bypass mode
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_fifo_stop(const struct device *dev);
+
+/**
+ * @brief drain the FIFO into an array of frames
+ *
+ * Reads the FIFO record count and then all complete packets that fit in
+ * @p frames and the driver's drain buffer in a single burst.
+ *
+ * @param dev icm42670 device pointer
+ * @param frames destination array
+ * @param max_frames capacity of @p frames
+ * @return int number of frames stored, negative error code otherwise
+ */
+int icm42670_fifo_read(const struct device *dev, struct icm42670_fifo_frame *frames,
+		       size_t max_frames);
+
+struct icm42670_consumer;
+
+/**
+ * @brief consumer handler, called with a batch of frames at the consumer rate
+ *
+ * Runs in the interrupt thread with the driver lock held, other driver calls
+ * from the handler are fine but should be kept short. It must not add or
+ * remove consumers.
+ *
+ * @param dev icm42670 device pointer
+ * @param consumer the consumer the frames belong to
+ * @param frames decimated frames, the storage given in @p consumer
+ * @param n number of frames
+ */
+typedef void (*icm42670_consumer_handler_t)(const struct device *dev,
+					    struct icm42670_consumer *consumer,
+					    const struct icm42670_fifo_frame *frames, size_t n);
+
+/**
+ * @brief one user of the samples of a device, at its own rate
+ *
+ * Each output frame is the mean of the FIFO samples since the previous one,
+ * with the timestamp and chip timestamp of the newest of them. Samples of
+ * two configuration generations are never averaged together.
+ */
+struct icm42670_consumer {
+	/** used by the driver, do not touch */
+	sys_snode_t node;
+	/** requested rate in Hz */
+	uint16_t hz;
+	/** called when @p frames is full and at the end of every drain */
+	icm42670_consumer_handler_t handler;
+	/** storage for the decimated frames */
+	struct icm42670_fifo_frame *frames;
+	/** capacity of @p frames */
+	size_t max_frames;
+	/** FIFO samples per output frame, set by the driver */
+	uint16_t decimation;
+	/* accumulator state, used by the driver */
+	uint16_t count;
+	uint16_t config_gen;
+	size_t pending;
+	int32_t sum[7];
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+	int32_t sum_hires[6];
+#endif
+};
+
+/**
+ * @brief register a consumer of the samples of a device
+ *
+ * The accel and gyro run at the lowest supported rate at or above the
+ * highest one any consumer asks for, 12 Hz at least, and the FIFO is
+ * started if needed. All consumers are fed from the same FIFO watermark
+ * drain, so a consumer adds no bus traffic of its own, but changing the
+ * sensor rate flushes samples not yet delivered. While consumers are
+ * registered SENSOR_ATTR_SAMPLING_FREQUENCY returns -EBUSY, and the FIFO
+ * must not be drained by anyone else.
+ *
+ * Only available with CONFIG_ICM42670_CONSUMERS.
+ *
+ * @param dev icm42670 device pointer
+ * @param consumer consumer with hz, handler, frames and max_frames set, it
+ *	  must stay valid until removed
+ * @return int 0 on success, -EINVAL for a bad consumer, -EALREADY if it is
+ *	   registered, negative error code otherwise
+ */
+int icm42670_consumer_add(const struct device *dev, struct icm42670_consumer *consumer);
+
+/**
+ * @brief unregister a consumer, frames not delivered yet are dropped
+ *
+ * The sensor rate follows the remaining consumers, and the FIFO is stopped
+ * with the last one if icm42670_consumer_add() started it.
+ *
+ * @param dev icm42670 device pointer
+ * @param consumer registered consumer
+ * @return int 0 on success, -ENOENT if it is not registered, negative error
+ *	   code otherwise
+ */
+int icm42670_consumer_remove(const struct device *dev, struct icm42670_consumer *consumer);
+
+/** @brief rate profiles of the motion policy */
+enum icm42670_motion_profile {
+	/** stationary, slow low power accel and gyro in standby */
+	ICM42670_PROFILE_IDLE,
+	/** moving, fast low noise accel and gyro */
+	ICM42670_PROFILE_ACTIVE,
+	ICM42670_PROFILE_COUNT,
+};
+
+/**
+ * @brief settings of the motion policy
+ *
+ * Motion is detected with the wake on motion thresholds and duration set
+ * through SENSOR_ATTR_SLOPE_TH and SENSOR_ATTR_SLOPE_DUR on the accel.
+ */
+struct icm42670_motion_policy {
+	/** accel rate while stationary, 1 to 400 Hz */
+	uint16_t idle_hz;
+	/** accel and gyro rate while moving, 12 to 1600 Hz */
+	uint16_t active_hz;
+	/** time without motion before dropping back to the idle profile */
+	uint32_t idle_after_ms;
+};
+
+/** @brief time spent in each profile since the policy started */
+struct icm42670_motion_policy_stats {
+	uint64_t time_ms[ICM42670_PROFILE_COUNT];
+	/** switches from idle to active */
+	uint32_t wakeups;
+	/** current profile, enum icm42670_motion_profile */
+	uint8_t profile;
+};
+
+/**
+ * @brief switch between an idle and an active rate profile with motion
+ *
+ * The device starts in the active profile. Wake on motion is routed to the
+ * interrupt line only in the idle profile, the interrupt thread switches to
+ * the active profile as soon as it fires. In the active profile the latched
+ * motion status is checked every @p idle_after_ms against a fresh reference
+ * sample, and the device drops back to idle after one period without
+ * motion. Switching flushes the FIFO like any rate change. While the policy
+ * runs SENSOR_ATTR_SAMPLING_FREQUENCY returns -EBUSY and the motion trigger
+ * can not be set.
+ *
+ * Only available with CONFIG_ICM42670_MOTION_POLICY.
+ *
+ * @param dev icm42670 device pointer
+ * @param policy profile settings, copied
+ * @return int 0 on success, -EINVAL for bad settings, -EBUSY if the policy
+ *	   runs already or a motion trigger is set, negative error code otherwise
+ */
+int icm42670_motion_policy_start(const struct device *dev,
+				 const struct icm42670_motion_policy *policy);
+
+/**
+ * @brief stop the motion policy and restore the previous rates and power mode
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, -EALREADY if it was not running, negative error
+ *	   code otherwise
+ */
+int icm42670_motion_policy_stop(const struct device *dev);
+
+/**
+ * @brief get the time spent in each profile, up to now
+ *
+ * @param dev icm42670 device pointer
+ * @param stats destination for the statistics
+ */
+void icm42670_motion_policy_stats_get(const struct device *dev,
+				      struct icm42670_motion_policy_stats *stats);
+
+/**
+ * @brief measure the accel and gyro bias and cancel it in the sensor
+ *
+ * The device must lie still with one axis pointing up or down. The mean of
+ * @p samples FIFO samples, minus gravity on the axis closest to it, is
+ * written to the sensor offset registers so every later sample is corrected
+ * at no cost. With CONFIG_ICM42670_CALIBRATION_SETTINGS the offsets are
+ * stored and restored at the next boot.
+ *
+ * @param dev icm42670 device pointer
+ * @param samples number of samples to average
+ * @return int 0 on success, -EBUSY if the FIFO is in use, -ETIMEDOUT if the
+ *	   samples did not arrive, negative error code otherwise
+ */
+int icm42670_calibrate(const struct device *dev, uint16_t samples);
+
+/**
+ * @brief remove the offsets set by icm42670_calibrate(), and the stored copy
+ *
+ * @param dev icm42670 device pointer
+ * @return int 0 on success, negative error code otherwise
+ */
+int icm42670_calibration_clear(const struct device *dev);
+
+/** @brief register classes bus transactions are accounted to */
+enum icm42670_bus_class {
+	/** sample, APEX output, status and FIFO registers */
+	ICM42670_BUS_CLASS_DATA,
+	/** bank 0 configuration registers */
+	ICM42670_BUS_CLASS_CONFIG,
+	/** MREG1-3 registers, reached through the BLK_SEL/MADDR window */
+	ICM42670_BUS_CLASS_MREG,
+	ICM42670_BUS_CLASS_COUNT,
+};
+
+/** number of bins of the bus latency histogram */
+#define ICM42670_BUS_HIST_BINS 8
+
+/** @brief bus use of one register class */
+struct icm42670_bus_class_stats {
+	uint32_t transactions;
+	uint32_t bytes;
+	/** transactions that still failed after all retries */
+	uint32_t errors;
+	/** attempts repeated after a failure */
+	uint32_t retries;
+	/** total time spent in the transactions */
+	uint64_t busy_us;
+};
+
+/** @brief bus statistics of one device, see CONFIG_ICM42670_BUS_STATS */
+struct icm42670_bus_stats {
+	struct icm42670_bus_class_stats classes[ICM42670_BUS_CLASS_COUNT];
+	/**
+	 * transaction latency, bin 0 counts latencies below 16 us, bin n those
+	 * from 8 << n to 16 << n us and the last bin everything above
+	 */
+	uint32_t latency_hist[ICM42670_BUS_HIST_BINS];
+	uint32_t max_latency_us;
+};
+
+/**
+ * @brief get the bus statistics gathered since boot or the last reset
+ *
+ * Only available with CONFIG_ICM42670_BUS_STATS.
+ *
+ * @param dev icm42670 device pointer
+ * @param stats destination for the statistics
+ */
+void icm42670_bus_stats_get(const struct device *dev, struct icm42670_bus_stats *stats);
+
+/**
+ * @brief clear the bus statistics
+ *
+ * @param dev icm42670 device pointer
+ */
+void icm42670_bus_stats_reset(const struct device *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_APP_DRIVERS_SENSOR_ICM42670_H_ */
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Test API of the ICM42670 emulator
+ *
+ * The emulator answers the driver on I2C or SPI with a register model of the
+ * device and produces samples at the configured rate, in the data registers
+ * and in the FIFO. Tests feed it constant samples or a waveform computed
+ * from the emulated time.
+ */
+
+#ifndef ZEPHYR_INCLUDE_APP_DRIVERS_SENSOR_ICM42670_EMUL_H_
+#define ZEPHYR_INCLUDE_APP_DRIVERS_SENSOR_ICM42670_EMUL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/drivers/emul.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief one sample in register units, as the sensor would measure it */
+struct icm42670_emul_sample {
+	/** accel x, y and z */
+	int16_t accel[3];
+	/** gyro x, y and z */
+	int16_t gyro[3];
+	/** die temperature, 128 LSB/C with 0 at 25 C */
+	int16_t temp;
+};
+
+/**
+ * @brief waveform callback, called for every sample the emulator produces
+ *
+ * @param target emulator instance
+ * @param time_us emulated sample time in microseconds since boot
+ * @param sample destination, holds the constant sample on entry
+ * @param user_data pointer given to icm42670_emul_set_waveform()
+ */
+typedef void (*icm42670_emul_waveform_t)(const struct emul *target, uint64_t time_us,
+					 struct icm42670_emul_sample *sample, void *user_data);
+
+/**
+ * @brief set the sample produced while no waveform is installed
+ *
+ * @param target emulator instance
+ * @param sample sample in register units
+ */
+void icm42670_emul_set_sample(const struct emul *target,
+			      const struct icm42670_emul_sample *sample);
+
+/**
+ * @brief install a waveform generator
+ *
+ * @param target emulator instance
+ * @param waveform generator, NULL to go back to the constant sample
+ * @param user_data passed to the generator
+ */
+void icm42670_emul_set_waveform(const struct emul *target, icm42670_emul_waveform_t waveform,
+				void *user_data);
+
+/**
+ * @brief write registers without bus side effects
+ *
+ * @param target emulator instance
+ * @param reg first register, with the MREG bank in the upper byte like the driver
+ * @param val values
+ * @param count number of registers
+ */
+void icm42670_emul_set_reg(const struct emul *target, uint16_t reg, const uint8_t *val,
+			   size_t count);
+
+/**
+ * @brief read registers without bus side effects
+ *
+ * @param target emulator instance
+ * @param reg first register, with the MREG bank in the upper byte like the driver
+ * @param val destination
+ * @param count number of registers
+ */
+void icm42670_emul_get_reg(const struct emul *target, uint16_t reg, uint8_t *val, size_t count);
+
+/**
+ * @brief number of bytes waiting in the emulated FIFO
+ *
+ * @param target emulator instance
+ * @return size_t FIFO fill level in bytes
+ */
+size_t icm42670_emul_fifo_level(const struct emul *target);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_APP_DRIVERS_SENSOR_ICM42670_EMUL_H_ */
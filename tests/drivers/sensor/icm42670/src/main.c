@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2024 Espressif Systems (Shanghai) Co., Ltd.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Driver regression tests against the emulator, run on native_sim for the
+ * instance on I2C and the one on SPI.
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/emul_sensor.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+#include <app/drivers/sensor/icm42670.h>
+#include <app/drivers/sensor/icm42670_emul.h>
+#include "icm42670_reg.h"
+
+#define ACCEL_TOLERANCE_MICRO	10000 /* m/s^2, a few LSB at +-16g */
+#define GYRO_TOLERANCE_MICRO	5000 /* rad/s, nominal 16.4 LSB/dps against 2^19/2000 */
+#define TEMP_TOLERANCE_MICRO	10000
+#define FIFO_FRAMES		16
+
+/* the emulated sample: 1g and -0.5g, 100dps and -50dps, 35 C */
+#define SAMPLE_ACCEL_MICRO	{ SENSOR_G, -SENSOR_G / 2, 0 }
+#define SAMPLE_GYRO_MICRO	{ 1745329, -872665, 0 }
+#define SAMPLE_TEMP_MICRO	35000000
+
+struct icm42670_instance {
+	const struct device *dev;
+	const struct emul *emul;
+};
+
+static const struct icm42670_instance instances[] = {
+	{
+		.dev = DEVICE_DT_GET(DT_NODELABEL(icm42670_i2c)),
+		.emul = EMUL_DT_GET(DT_NODELABEL(icm42670_i2c)),
+	},
+	{
+		.dev = DEVICE_DT_GET(DT_NODELABEL(icm42670_spi)),
+		.emul = EMUL_DT_GET(DT_NODELABEL(icm42670_spi)),
+	},
+};
+
+static const int32_t accel_fs[] = { 16, 8, 4, 2 };
+static const int32_t gyro_fs[] = { 2000, 1000, 500, 250 };
+
+/* the sample in register units at the given FS_SEL values */
+static struct icm42670_emul_sample test_sample(uint8_t accel_sel, uint8_t gyro_sel)
+{
+	return (struct icm42670_emul_sample){
+		.accel = { 2048 << accel_sel, -(1024 << accel_sel), 0 },
+		.gyro = { 1640 << gyro_sel, -(820 << gyro_sel), 0 },
+		.temp = 10 * 128,
+	};
+}
+
+static void set_full_scale(const struct device *dev, uint8_t accel_sel, uint8_t gyro_sel)
+{
+	struct sensor_value val = { .val1 = accel_fs[accel_sel] };
+
+	zassert_ok(sensor_attr_set(dev, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_FULL_SCALE, &val));
+
+	val.val1 = gyro_fs[gyro_sel];
+	zassert_ok(sensor_attr_set(dev, SENSOR_CHAN_GYRO_XYZ, SENSOR_ATTR_FULL_SCALE, &val));
+}
+
+static void set_rate(const struct device *dev, int32_t hz)
+{
+	struct sensor_value val = { .val1 = hz };
+
+	zassert_ok(sensor_attr_set(dev, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY,
+				   &val));
+	zassert_ok(sensor_attr_set(dev, SENSOR_CHAN_GYRO_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY,
+				   &val));
+}
+
+static void check_values(const struct sensor_value *val, const int64_t *expected,
+			 int64_t tolerance)
+{
+	for (int i = 0; i < 3; i++) {
+		zassert_within(sensor_value_to_micro(&val[i]), expected[i], tolerance,
+			       "axis %d: %lld, expected %lld", i,
+			       (long long)sensor_value_to_micro(&val[i]), (long long)expected[i]);
+	}
+}
+
+static void check_micro(const int32_t *micro, const int64_t *expected, int64_t tolerance)
+{
+	for (int i = 0; i < 3; i++) {
+		zassert_within(micro[i], expected[i], tolerance, "axis %d: %d, expected %lld", i,
+			       micro[i], (long long)expected[i]);
+	}
+}
+
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+static void check_hires(enum sensor_channel chan, const int32_t *raw, const int64_t *expected,
+			int64_t tolerance)
+{
+	struct icm42670_scale scale;
+	int32_t micro[3];
+	q31_t q31[3];
+
+	zassert_ok(icm42670_get_hires_scale(chan, &scale));
+	icm42670_convert_hires_to_q31(&scale, raw, q31, 3);
+
+	for (int i = 0; i < 3; i++) {
+		micro[i] = ((int64_t)q31[i] * 1000000) >> (31 - scale.q31_shift);
+	}
+
+	check_micro(micro, expected, tolerance);
+}
+#endif
+
+/* drain everything buffered, returns the number of frames */
+static int fifo_drain(const struct device *dev)
+{
+	struct icm42670_fifo_frame frames[FIFO_FRAMES];
+	int total = 0;
+	int n;
+
+	do {
+		n = icm42670_fifo_read(dev, frames, ARRAY_SIZE(frames));
+		zassert_true(n >= 0, "FIFO read failed (%d)", n);
+		total += n;
+	} while (n > 0);
+
+	return total;
+}
+
+static void icm42670_before(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	ARRAY_FOR_EACH_PTR(instances, inst) {
+		struct icm42670_emul_sample sample = test_sample(0, 0);
+
+		(void)icm42670_fifo_stop(inst->dev);
+		set_full_scale(inst->dev, 0, 0);
+		set_rate(inst->dev, 800);
+		icm42670_emul_set_waveform(inst->emul, NULL, NULL);
+		icm42670_emul_set_sample(inst->emul, &sample);
+	}
+}
+
+ZTEST(icm42670, test_fetch_get)
+{
+	const int64_t accel[] = SAMPLE_ACCEL_MICRO;
+	const int64_t gyro[] = SAMPLE_GYRO_MICRO;
+
+	ARRAY_FOR_EACH_PTR(instances, inst) {
+		struct sensor_value val[3];
+
+		zassert_true(device_is_ready(inst->dev));
+		zassert_ok(sensor_sample_fetch(inst->dev));
+
+		zassert_ok(sensor_channel_get(inst->dev, SENSOR_CHAN_ACCEL_XYZ, val));
+		check_values(val, accel, ACCEL_TOLERANCE_MICRO);
+
+		zassert_ok(sensor_channel_get(inst->dev, SENSOR_CHAN_GYRO_XYZ, val));
+		check_values(val, gyro, GYRO_TOLERANCE_MICRO);
+
+		zassert_ok(sensor_channel_get(inst->dev, SENSOR_CHAN_DIE_TEMP, val));
+		zassert_within(sensor_value_to_micro(&val[0]), SAMPLE_TEMP_MICRO,
+			       TEMP_TOLERANCE_MICRO);
+	}
+}
+
+ZTEST(icm42670, test_emul_backend)
+{
+	/* 1g on z through the generic emulator API, in q31 with 8 integer bits */
+	const q31_t one_g = ((int64_t)SENSOR_G << (31 - 8)) / 1000000;
+	struct sensor_chan_spec chan = { .chan_type = SENSOR_CHAN_ACCEL_Z };
+
+	ARRAY_FOR_EACH_PTR(instances, inst) {
+		struct sensor_value val;
+
+		zassert_ok(emul_sensor_backend_set_channel(inst->emul, chan, &one_g, 8));
+		zassert_ok(sensor_sample_fetch(inst->dev));
+		zassert_ok(sensor_channel_get(inst->dev, SENSOR_CHAN_ACCEL_Z, &val));
+		zassert_within(sensor_value_to_micro(&val), SENSOR_G, ACCEL_TOLERANCE_MICRO);
+	}
+}
+
+ZTEST(icm42670, test_full_scale)
+{
+	const int64_t accel[] = SAMPLE_ACCEL_MICRO;
+	const int64_t gyro[] = SAMPLE_GYRO_MICRO;
+
+	ARRAY_FOR_EACH_PTR(instances, inst) {
+		for (uint8_t sel = 0; sel < ARRAY_SIZE(accel_fs); sel++) {
+			struct icm42670_emul_sample sample = test_sample(sel, sel);
+			uint16_t gen = icm42670_config_gen(inst->dev);
+			struct icm42670_raw_sample raw;
+			struct sensor_value val[3];
+			uint8_t reg;
+
+			set_full_scale(inst->dev, sel, sel);
+			zassert_not_equal(icm42670_config_gen(inst->dev), gen,
+					  "full scale change kept the configuration generation");
+
+			icm42670_emul_get_reg(inst->emul, REG_ACCEL_CONFIG0, &reg, 1);
+			zassert_equal(FIELD_GET(MASK_ACCEL_UI_FS_SEL, reg), sel);
+			icm42670_emul_get_reg(inst->emul, REG_GYRO_CONFIG0, &reg, 1);
+			zassert_equal(FIELD_GET(MASK_GYRO_UI_FS_SEL, reg), sel);
+
+			icm42670_emul_set_sample(inst->emul, &sample);
+			zassert_ok(icm42670_fetch_raw(inst->dev, &raw));
+			zassert_equal(raw.config_gen, icm42670_config_gen(inst->dev));
+			zassert_equal(raw.accel[0], sample.accel[0]);
+			zassert_equal(raw.gyro[0], sample.gyro[0]);
+
+			/* the same physical values whatever the range */
+			zassert_ok(sensor_channel_get(inst->dev, SENSOR_CHAN_ACCEL_XYZ, val));
+			check_values(val, accel, ACCEL_TOLERANCE_MICRO);
+			zassert_ok(sensor_channel_get(inst->dev, SENSOR_CHAN_GYRO_XYZ, val));
+			check_values(val, gyro, GYRO_TOLERANCE_MICRO);
+		}
+	}
+}
+
+ZTEST(icm42670, test_sampling_rate)
+{
+	static const struct {
+		int32_t hz;
+		uint8_t accel_odr;
+		uint8_t gyro_odr;
+	} rates[] = {
+		{ 100, BIT_ACCEL_ODR_100, BIT_GYRO_ODR_100 },
+		{ 400, BIT_ACCEL_ODR_400, BIT_GYRO_ODR_400 },
+		{ 1600, BIT_ACCEL_ODR_1600, BIT_GYRO_ODR_1600 },
+	};
+
+	ARRAY_FOR_EACH_PTR(instances, inst) {
+		ARRAY_FOR_EACH_PTR(rates, rate) {
+			uint16_t gen = icm42670_config_gen(inst->dev);
+			uint8_t reg;
+
+			set_rate(inst->dev, rate->hz);
+			zassert_not_equal(icm42670_config_gen(inst->dev), gen,
+					  "rate change kept the configuration generation");
+
+			icm42670_emul_get_reg(inst->emul, REG_ACCEL_CONFIG0, &reg, 1);
+			zassert_equal(FIELD_GET(MASK_ACCEL_ODR, reg), rate->accel_odr);
+			icm42670_emul_get_reg(inst->emul, REG_GYRO_CONFIG0, &reg, 1);
+			zassert_equal(FIELD_GET(MASK_GYRO_ODR, reg), rate->gyro_odr);
+
+			zassert_ok(sensor_sample_fetch(inst->dev));
+		}
+
+		/* the FIFO fills at the configured rate */
+		set_rate(inst->dev, 100);
+		zassert_ok(icm42670_fifo_start(inst->dev));
+		k_msleep(200);
+		zassert_within(fifo_drain(inst->dev), 20, 3);
+		zassert_ok(icm42670_fifo_stop(inst->dev));
+	}
+}
+
+ZTEST(icm42670, test_fifo_decode)
+{
+	const int64_t accel[] = SAMPLE_ACCEL_MICRO;
+	const int64_t gyro[] = SAMPLE_GYRO_MICRO;
+	/* the +-16g and +-2000dps ranges, then ranges the high resolution FIFO ignores */
+	static const uint8_t sels[] = { 0, 2 };
+
+	ARRAY_FOR_EACH_PTR(instances, inst) {
+		ARRAY_FOR_EACH(sels, s) {
+			struct icm42670_emul_sample sample = test_sample(sels[s], sels[s]);
+			struct icm42670_fifo_frame frames[FIFO_FRAMES];
+			int n;
+
+			set_full_scale(inst->dev, sels[s], sels[s]);
+			icm42670_emul_set_sample(inst->emul, &sample);
+
+			zassert_ok(icm42670_fifo_start(inst->dev));
+			k_msleep(10);
+			n = icm42670_fifo_read(inst->dev, frames, ARRAY_SIZE(frames));
+			zassert_ok(icm42670_fifo_stop(inst->dev));
+			zassert_true(n > 0, "no FIFO frames (%d)", n);
+
+			for (int i = 0; i < n; i++) {
+				const struct icm42670_fifo_frame *frame = &frames[i];
+				int32_t micro[3];
+
+				zassert_equal(frame->config_gen, icm42670_config_gen(inst->dev));
+				zassert_equal(frame->temp, sample.temp);
+
+				icm42670_convert_to_micro(frame->accel_scale, frame->accel, micro,
+							  3);
+				check_micro(micro, accel, ACCEL_TOLERANCE_MICRO);
+				icm42670_convert_to_micro(frame->gyro_scale, frame->gyro, micro, 3);
+				check_micro(micro, gyro, GYRO_TOLERANCE_MICRO);
+
+#ifdef CONFIG_ICM42670_FIFO_HIRES
+				/* 20-bit values at 2^15 LSB/g, the 16-bit view at +-16g */
+				zassert_equal(frame->accel_hires[0], 32768);
+				zassert_equal(frame->accel[0], 2048);
+				check_hires(SENSOR_CHAN_ACCEL_XYZ, frame->accel_hires, accel,
+					    ACCEL_TOLERANCE_MICRO);
+				check_hires(SENSOR_CHAN_GYRO_XYZ, frame->gyro_hires, gyro,
+					    GYRO_TOLERANCE_MICRO);
+#else
+				zassert_equal(frame->accel[0], sample.accel[0]);
+				zassert_equal(frame->gyro[0], sample.gyro[0]);
+#endif
+			}
+		}
+	}
+}
+
+ZTEST_SUITE(icm42670, NULL, NULL, icm42670_before, NULL, NULL);